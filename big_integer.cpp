@@ -1,11 +1,16 @@
 #include "big_integer.h"
+#include "limb_arith.h"
+#include "limb_kernels.h"
 #include <algorithm>
-#include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
 
 using namespace std;
 
 const uint32_t BASE_ARRAY = 32;
-const int BASE_INT = (int)10e8;
 
 template<typename T>
 uint32_t toUint32(T x) {
@@ -56,6 +61,107 @@ big_integer big_integer::abs() const {
     else return *this;
 }
 
+size_t big_integer::bit_length() const {
+    uint32_t fill = sign ? 0xffffffff : 0;
+    size_t n = size();
+    while (n > 0 && array[n - 1] == fill) n--;
+    if (n == 0) return sign ? 1 : 0;
+
+    // for negatives the limbs are those of ~this = |this| - 1, which is one bit shorter than
+    // |this| when |this| is a power of two, i.e. when all its bits are ones
+    uint32_t top = array[n - 1] ^ fill;
+    size_t bits = 32 * n;
+    for (uint32_t t = top; !(t & 0x80000000u); t <<= 1) bits--;
+    if (sign && ((top + 1) & top) == 0) {
+        size_t i = 0;
+        while (i < n - 1 && array[i] == 0) i++;
+        if (i == n - 1) bits++;
+    }
+    return bits;
+}
+
+size_t big_integer::ilog2() const {
+    if (sign || is_zero()) throw runtime_error("logarithm of a non-positive number");
+    return bit_length() - 1;
+}
+
+static unsigned low_zeros(uint32_t x) {
+    unsigned n = 0;
+    for (; !(x & 1); x >>= 1) n++;
+    return n;
+}
+
+bool big_integer::test_bit(size_t k) const {
+    return (get_digit(k / BASE_ARRAY) >> (k % BASE_ARRAY)) & 1;
+}
+
+// Writes bit k as value. A bit beyond the limbs equals the sign, so only changing it needs
+// the limbs up to it; the top limb may turn into fill, which delete_zero drops.
+void big_integer::put_bit(size_t k, bool value) {
+    if (test_bit(k) == value) return;
+    size_t limb = k / BASE_ARRAY, n = size();
+    array.prepare_to_new(limb + 1);
+    if (limb >= n) {
+        array.resize(limb + 1);
+        if (sign) memset(array.data() + n, 0xff, (limb + 1 - n) * sizeof(uint32_t));
+    }
+    array[limb] ^= 1u << (k % BASE_ARRAY);
+    delete_zero();
+}
+
+void big_integer::set_bit(size_t k) {
+    put_bit(k, true);
+}
+
+void big_integer::clear_bit(size_t k) {
+    put_bit(k, false);
+}
+
+void big_integer::flip_bit(size_t k) {
+    put_bit(k, !test_bit(k));
+}
+
+size_t big_integer::popcount() const {
+    if (sign) return SIZE_MAX;
+    return limbs_popcount(array.data(), size());
+}
+
+size_t hamming_distance(big_integer const& a, big_integer const& b) {
+    if (a.sign != b.sign) return SIZE_MAX;
+    big_integer const& longer = a.size() >= b.size() ? a : b;
+    big_integer const& shorter = a.size() >= b.size() ? b : a;
+    size_t n = shorter.size(), m = longer.size() - n;
+    // above the shorter one, the bits of the longer one are compared with its fill
+    size_t rest = limbs_popcount(longer.array.data() + n, m);
+    if (a.sign) rest = BASE_ARRAY * m - rest;
+    return limbs_hamming(a.array.data(), b.array.data(), n) + rest;
+}
+
+size_t big_integer::count_trailing_zeros() const {
+    return scan1(0);
+}
+
+// The first position >= from whose bit differs from those of fill, i.e. of a one bit for
+// fill 0 and of a zero bit for fill 0xffffffff.
+size_t big_integer::scan(size_t from, uint32_t fill) const {
+    size_t limb = from / BASE_ARRAY;
+    if (limb < size()) {
+        uint32_t x = (array[limb] ^ fill) & (0xffffffffu << (from % BASE_ARRAY));
+        while (x == 0 && ++limb < size()) x = array[limb] ^ fill;
+        if (x != 0) return limb * BASE_ARRAY + low_zeros(x);
+    }
+    if ((sign ? 0xffffffff : 0) == fill) return SIZE_MAX;
+    return std::max(from, size() * BASE_ARRAY);
+}
+
+size_t big_integer::scan1(size_t from) const {
+    return scan(from, 0);
+}
+
+size_t big_integer::scan0(size_t from) const {
+    return scan(from, 0xffffffff);
+}
+
 void big_integer::swap(big_integer &num) noexcept {
     std::swap(array, num.array);
     std::swap(sign, num.sign);
@@ -104,6 +210,12 @@ big_integer::big_integer(uint64_t a) : sign(0), array(2) {
     delete_zero();
 }
 
+big_integer::big_integer(int64_t a) : sign(a < 0), array(2) {
+    array[0] = toUint32(a);
+    array[1] = toUint32(a >> BASE_ARRAY);
+    delete_zero();
+}
+
 big_integer &big_integer::operator=(big_integer const &num) {
     big_integer temp(num);
     swap(temp);
@@ -149,118 +261,142 @@ big_integer big_integer::operator--(int) {
 }
 
 big_integer operator&(big_integer const &a, big_integer const &b) {
-    size_t n = max(a.size(), b.size()), m = min(a.size(), b.size());
+    big_integer const &lo = (a.size() < b.size()) ? a : b;
+    big_integer const &hi = (a.size() < b.size()) ? b : a;
+    size_t n = hi.size(), m = lo.size();
     fast_vector temp(n);
-    for (size_t i = 0; i < m; i++) {
-        temp[i] = a.get_real_digit(i) & b.get_real_digit(i);
-    }
-    for (size_t i = m; i < n; i++) {
-        temp[i] = a.get_digit(i) & b.get_digit(i);
-    }
+    limbs_and(temp.data(), a.array.data(), b.array.data(), m);
+    if (lo.sign) memcpy(temp.data() + m, hi.array.data() + m, (n - m) * sizeof(uint32_t));
     return big_integer(a.sign & b.sign, temp);
 }
 
 big_integer operator|(big_integer const &a, big_integer const &b) {
-    size_t n = max(a.size(), b.size()), m = min(a.size(), b.size());
+    big_integer const &lo = (a.size() < b.size()) ? a : b;
+    big_integer const &hi = (a.size() < b.size()) ? b : a;
+    size_t n = hi.size(), m = lo.size();
     fast_vector temp(n);
-    for (size_t i = 0; i < m; i++) {
-        temp[i] = a.get_real_digit(i) | b.get_real_digit(i);
-    }
-    for (size_t i = m; i < n; i++) {
-        temp[i] = a.get_digit(i) | b.get_digit(i);
-    }
+    limbs_or(temp.data(), a.array.data(), b.array.data(), m);
+    if (lo.sign) memset(temp.data() + m, 0xff, (n - m) * sizeof(uint32_t));
+    else memcpy(temp.data() + m, hi.array.data() + m, (n - m) * sizeof(uint32_t));
     return big_integer(a.sign | b.sign, temp);
 }
 
 big_integer operator^(big_integer const &a, big_integer const &b) {
-    size_t n = max(a.size(), b.size()), m = min(a.size(), b.size());
+    big_integer const &lo = (a.size() < b.size()) ? a : b;
+    big_integer const &hi = (a.size() < b.size()) ? b : a;
+    size_t n = hi.size(), m = lo.size();
     fast_vector temp(n);
-    for (size_t i = 0; i < m; i++) {
-        temp[i] = a.get_real_digit(i) ^ b.get_real_digit(i);
-    }
-    for (size_t i = m; i < n; i++) {
-        temp[i] = a.get_digit(i) ^ b.get_digit(i);
-    }
+    limbs_xor(temp.data(), a.array.data(), b.array.data(), m);
+    if (lo.sign) limbs_not(temp.data() + m, hi.array.data() + m, n - m);
+    else memcpy(temp.data() + m, hi.array.data() + m, (n - m) * sizeof(uint32_t));
     return big_integer(a.sign ^ b.sign, temp);
 }
 
-big_integer operator<<(big_integer const &a, uint32_t b) {
-    if (b == 0) return big_integer(a);
-    size_t div = b >> 5;
-    size_t mod = b & (BASE_ARRAY - 1);
-    size_t new_size = a.size() + div + 1;
-    fast_vector temp(new_size);
-    temp[div] = toUint32(uint64_t(a.get_digit(0)) << mod);
-    for (size_t i = div + 1; i < new_size; i++) {
-        uint64_t x = uint64_t(a.get_digit(i - div)) << mod;
-        uint64_t y = uint64_t(a.get_real_digit(i - div - 1)) >> (BASE_ARRAY - mod);
-        temp[i] = toUint32(x | y);
+// b / 32 as a limb count, throwing if a number shifted by b bits would not fit in memory
+static size_t shift_limbs(uint64_t b, size_t n) {
+    if ((b >> 5) > SIZE_MAX / sizeof(uint32_t) - n - 1) throw runtime_error("shift is too large");
+    return static_cast<size_t>(b >> 5);
+}
+
+big_integer operator<<(big_integer const &a, uint64_t b) {
+    if (b == 0 || a.is_zero()) return big_integer(a);
+    size_t n = a.size();
+    size_t div = shift_limbs(b, n);
+    unsigned mod = b & (BASE_ARRAY - 1);
+    uint32_t ext = a.sign ? 0xffffffff : 0;
+    fast_vector temp(n + div + 1);
+    uint32_t *dst = temp.data() + div;
+    if (mod == 0) {
+        memcpy(dst, a.array.data(), n * sizeof(uint32_t));
+        dst[n] = ext;
+    } else {
+        uint32_t out = (n > 0) ? limbs_lshift(dst, a.array.data(), n, mod) : 0;
+        dst[n] = (ext << mod) | out;
     }
     return big_integer(a.sign, temp);
 }
 
-big_integer operator>>(big_integer const &a, uint32_t b) {
+big_integer operator>>(big_integer const &a, uint64_t b) {
     if (b == 0) return big_integer(a);
-    size_t div = b >> 5;
-    size_t mod = b & (BASE_ARRAY - 1);
-    size_t new_size = 0;
-    if (div < a.size()) new_size = a.size() - div;
-    fast_vector temp(new_size);
-    for (size_t i = 0; i < new_size; i++) {
-        uint64_t x = uint64_t(a.get_real_digit(i + div)) >> mod;
-        uint64_t y = uint64_t(a.get_digit(i + div + 1)) << (BASE_ARRAY - mod);
-        temp[i] = toUint32(x | y);
+    size_t div = (b >> 5) < a.size() ? static_cast<size_t>(b >> 5) : a.size();
+    unsigned mod = b & (BASE_ARRAY - 1);
+    size_t n = a.size() - div;
+    uint32_t ext = a.sign ? 0xffffffff : 0;
+    fast_vector temp(n);
+    if (n > 0) {
+        if (mod == 0) {
+            memcpy(temp.data(), a.array.data() + div, n * sizeof(uint32_t));
+        } else {
+            limbs_rshift(temp.data(), a.array.data() + div, n, mod);
+            temp[n - 1] |= ext << (BASE_ARRAY - mod);
+        }
     }
     return big_integer(a.sign, temp);
 }
 
-int dec_pow(uint32_t st) {
-    if (st == 0) return 1;
-    if (st % 2) return dec_pow(st - 1) * 10;
-    int t = dec_pow(st >> 1);
-    return t * t;
+// Numbers are compared in their canonical form, in which the top limb differs from the fill:
+// the sign decides first, then the length, which for negatives ranks the longer one lower,
+// and only numbers of the same sign and length need their limbs compared from the top.
+static int compare_limbs(bool as, uint32_t const *a, size_t an, bool bs, uint32_t const *b, size_t bn) {
+    if (as != bs) return as ? -1 : 1;
+    if (an != bn) return (an > bn) != as ? 1 : -1;
+    return limbs_cmp(a, b, an);
+}
+
+// the canonical limbs of a two's complement 64-bit value, returning their count
+static size_t small_limbs(uint64_t x, bool negative, uint32_t *limbs) {
+    uint32_t fill = negative ? 0xffffffff : 0;
+    limbs[0] = toUint32(x);
+    limbs[1] = toUint32(x >> BASE_ARRAY);
+    size_t n = 2;
+    while (n > 0 && limbs[n - 1] == fill) n--;
+    return n;
+}
+
+int compare(big_integer const &a, big_integer const &b) {
+    return compare_limbs(a.sign, a.array.data(), a.size(), b.sign, b.array.data(), b.size());
+}
+
+int compare(big_integer const &a, int64_t b) {
+    uint32_t limbs[2];
+    size_t n = small_limbs(static_cast<uint64_t>(b), b < 0, limbs);
+    return compare_limbs(a.sign, a.array.data(), a.size(), b < 0, limbs, n);
+}
+
+int compare(big_integer const &a, uint64_t b) {
+    uint32_t limbs[2];
+    size_t n = small_limbs(b, false, limbs);
+    return compare_limbs(a.sign, a.array.data(), a.size(), false, limbs, n);
 }
 
 bool operator==(big_integer const &a, big_integer const &b) {
-    return (!a.array.size() && !b.array.size()) || ((a.sign == b.sign) && (a.array == b.array));
+    return compare(a, b) == 0;
 }
 
 bool operator!=(big_integer const &a, big_integer const &b) {
-    return !(a == b);
+    return compare(a, b) != 0;
 }
 
 bool operator>(big_integer const &a, big_integer const &b) {
-    if (a == b) return false;
-    if (a.sign != b.sign) return b.sign;
-    if (a.size() != b.size()) return (b.size() < a.size());
-    for (size_t i = a.size(); i > 0; i--) {
-        uint32_t e = (a.get_digit(i - 1) - b.get_digit(i - 1));
-        if (e) return a.get_digit(i - 1) > b.get_digit(i - 1);
-    }
-    return 0;
+    return compare(a, b) > 0;
 }
 
 bool operator<(big_integer const &a, big_integer const &b) {
-    return b > a;
+    return compare(a, b) < 0;
 }
 
 bool operator<=(big_integer const &a, big_integer const &b) {
-    return !(a > b);
+    return compare(a, b) <= 0;
 }
 
 bool operator>=(big_integer const &a, big_integer const &b) {
-    return !(a < b);
+    return compare(a, b) >= 0;
 }
 
 big_integer operator+(big_integer const &a, big_integer const &b) {
     size_t n = max(a.size(), b.size()) + 2, m = min(a.size(), b.size());
     fast_vector temp(n);
-    uint64_t carry = 0, sum = 0;
-    for (size_t i = 0; i < m; i++) {
-        sum = (carry + a.get_real_digit(i)) + b.get_real_digit(i);
-        temp[i] = toUint32(sum);
-        carry = sum >> BASE_ARRAY;
-    }
+    uint64_t carry = limbs_add(temp.data(), a.array.data(), b.array.data(), m), sum = 0;
     for (size_t i = m; i < n; i++) {
         sum = (carry + a.get_digit(i)) + b.get_digit(i);
         temp[i] = toUint32(sum);
@@ -270,64 +406,27 @@ big_integer operator+(big_integer const &a, big_integer const &b) {
 }
 
 big_integer operator-(big_integer const &a, big_integer const &b) {
-    size_t n = max(a.size(), b.size()) + 3, m = min(a.size(), b.size());
+    size_t n = max(a.size(), b.size()) + 2, m = min(a.size(), b.size());
     fast_vector temp(n);
-    uint64_t carry = 0, sum = 0;
-    if (m > 0) {
-        sum = toUint64(a.get_real_digit(0)) + 1ULL + toUint64(~b.get_real_digit(0));
-        temp[0] = toUint32(sum);
-        carry = sum >> BASE_ARRAY;
-        for (size_t i = 1; i < m; i++) {
-            sum = carry + toUint64(a.get_real_digit(i)) + toUint64(~b.get_real_digit(i));
-            temp[i] = toUint32(sum);
-            carry = sum >> BASE_ARRAY;
-        }
-        for (size_t i = m; i < n; i++) {
-            sum = carry + toUint64(a.get_digit(i)) + toUint64(~b.get_digit(i));
-            temp[i] = toUint32(sum);
-            carry = sum >> BASE_ARRAY;
-        }
-    }
-    else {
-        sum = toUint64(a.get_digit(0)) + 1ULL + toUint64(~b.get_digit(0));
-        temp[0] = toUint32(sum);
-        carry = sum >> BASE_ARRAY;
-        for (size_t i = 1; i < n; i++) {
-            sum = carry + toUint64(a.get_digit(i)) + toUint64(~b.get_digit(i));
-            temp[i] = toUint32(sum);
-            carry = sum >> BASE_ARRAY;
-        }
+    uint64_t borrow = limbs_sub(temp.data(), a.array.data(), b.array.data(), m), diff = 0;
+    for (size_t i = m; i < n; i++) {
+        diff = toUint64(a.get_digit(i)) - b.get_digit(i) - borrow;
+        temp[i] = toUint32(diff);
+        borrow = (diff >> BASE_ARRAY) & 1;
     }
     return big_integer(temp.back() & (1 << (BASE_ARRAY - 1)), temp);
-
 }
 
 fast_vector mul_vector(fast_vector const &a, fast_vector const &b) {
     fast_vector res(a.size() + b.size() + 1);
-    for (size_t i = 0; i < a.size(); i++) {
-        uint64_t carry = 0, mul = 0, tmp = 0;
-        for (size_t j = 0; j < b.size(); j++) {
-            size_t k = i + j;
-            mul = uint64_t(a[i]) * b[j];
-            tmp = (mul & 0xffffffff) + res[k] + carry;
-            res[k] = toUint32(tmp);
-            carry = (mul >> BASE_ARRAY) + (tmp >> BASE_ARRAY);
-        }
-        res[i + b.size()] += toUint32(carry);
-    }
+    if (a.size() >= b.size()) limbs_mul(res.data(), a.data(), a.size(), b.data(), b.size());
+    else limbs_mul(res.data(), b.data(), b.size(), a.data(), a.size());
     return  res;
 }
 
 fast_vector mul_big_small(fast_vector const &a, const uint32_t b) {
     fast_vector res(a.size() + 1);
-    uint64_t carry = 0, mul = 0, tmp = 0;
-    for (size_t i = 0; i < a.size(); i++) {
-        mul = uint64_t(a[i]) * b;
-        tmp = (mul & 0xffffffff) + carry;
-        res[i] = toUint32(tmp);
-        carry = (mul >> BASE_ARRAY) + (tmp >> BASE_ARRAY);
-    }
-    res[a.size()] = toUint32(carry);
+    res[a.size()] = limbs_mul_1(res.data(), a.data(), a.size(), b);
     return res;
 }
 
@@ -353,7 +452,7 @@ void big_integer::correct() {
 big_integer operator*(big_integer const &a, big_integer const &b) {
     if (a.is_zero() || b.is_zero()) return big_integer(0);
     big_integer apos(a.abs());
-    big_integer bpos(b.abs());
+    big_integer bpos(&a == &b ? apos : b.abs());
     if (apos.size() > bpos.size()) apos.swap(bpos);
     fast_vector temp;
     if (apos.size() == 1) temp = mul_big_small(bpos.array, apos.get_real_digit(0));
@@ -363,107 +462,261 @@ big_integer operator*(big_integer const &a, big_integer const &b) {
     return res;
 }
 
-int string_to_int(string const &s) {
-    int ans = 0;
-    for (auto a : s) {
-        if (a < '0' || a > '9') throw runtime_error("symbol " + s + " not correct");
-        ans = ans * 10 + (a-'0');
+big_integer big_integer::pow(uint64_t n) const {
+    if (n == 0) return 1;
+    fast_vector const mag = magnitude();
+    size_t an = mag.size();
+    while (an > 0 && mag[an - 1] == 0) an--;
+    if (an == 0) return 0;
+
+    // |this| = odd * 2^zeros, and the power of two turns into a shift of odd^n
+    size_t low = 0;
+    while (mag[low] == 0) low++;
+    unsigned bit = 0;
+    while (!((mag[low] >> bit) & 1)) bit++;
+    uint64_t zeros = low * 32 + bit;
+    if (zeros != 0 && n > (UINT64_MAX >> 1) / zeros) throw runtime_error("power is too large");
+    zeros *= n;
+    vector<uint32_t> odd(mag.data() + low, mag.data() + an);
+    if (bit != 0) limbs_rshift(odd.data(), odd.data(), odd.size(), bit);
+    if (odd.back() == 0) odd.pop_back();
+
+    // left-to-right binary powering; a one-limb odd part is multiplied in by a single row
+    vector<uint32_t> res(odd), tmp;
+    int top = 63;
+    while (!((n >> top) & 1)) top--;
+    for (int i = top - 1; i >= 0 && (odd.size() > 1 || odd[0] != 1); i--) {
+        tmp.resize(2 * res.size());
+        limbs_sqr(tmp.data(), res.data(), res.size());
+        if (tmp.back() == 0) tmp.pop_back();
+        res.swap(tmp);
+        if (!((n >> i) & 1)) continue;
+        if (odd.size() == 1) {
+            uint32_t high = limbs_mul_1(res.data(), res.data(), res.size(), odd[0]);
+            if (high != 0) res.push_back(high);
+        } else {
+            tmp.resize(res.size() + odd.size());
+            limbs_mul(tmp.data(), res.data(), res.size(), odd.data(), odd.size());
+            if (tmp.back() == 0) tmp.pop_back();
+            res.swap(tmp);
+        }
     }
-    return ans;
-}
 
-big_integer string_to_number(string const &s) {
-    big_integer res(0);
-    size_t begin = 0;
-    if (s[begin] == '-') begin++;
-    for (size_t i = begin; i + 9 <= s.size(); i += 9) {
-        res = res * BASE_INT + string_to_int(s.substr(i, 9));
+    size_t limbs = zeros / 32;
+    unsigned shift = zeros % 32;
+    fast_vector out(limbs + res.size() + 1);
+    if (shift == 0) memcpy(out.data() + limbs, res.data(), res.size() * sizeof(uint32_t));
+    else out[limbs + res.size()] = limbs_lshift(out.data() + limbs, res.data(), res.size(), shift);
+    big_integer result(false, out);
+    return (sign && (n & 1)) ? -result : result;
+}
+
+big_integer big_integer::from_magnitude(bool negative, uint32_t const *mag, size_t n) {
+    fast_vector temp(n + 1);
+    memcpy(temp.data(), mag, n * sizeof(uint32_t));
+    big_integer res(false, temp);
+    return negative ? -res : res;
+}
+
+fast_vector big_integer::magnitude() const {
+    return sign ? (-*this).array : array;
+}
+
+// The limbs of the integer part of |a|, taken 32 bits at a time from the top: every step
+// removes the top limb exactly, so there are at most as many as the mantissa has limbs.
+template<typename F>
+static big_integer from_floating(F a) {
+    if (!std::isfinite(a)) throw runtime_error("not a finite number");
+    F t = std::trunc(std::fabs(a));
+    if (t < 1) return big_integer();
+    int e;
+    std::frexp(t, &e);
+    size_t n = (e + BASE_ARRAY - 1) / BASE_ARRAY;
+    vector<uint32_t> mag(n);
+    for (size_t i = n; i > 0 && t != 0; i--) {
+        F limb = std::trunc(std::ldexp(t, -int(BASE_ARRAY * (i - 1))));
+        mag[i - 1] = static_cast<uint32_t>(limb);
+        t -= std::ldexp(limb, int(BASE_ARRAY * (i - 1)));
     }
-    uint32_t mod = (s.size() - begin) % 9;
-    if (mod > 0) res = res * dec_pow(mod) + string_to_int(s.substr(s.size() - mod, mod));
-    return (begin % 2 != 0) ? -res : res;
+    return big_integer::from_magnitude(a < 0, mag.data(), n);
 }
 
-big_integer::big_integer(string const &str) :big_integer(string_to_number(str)) {}
+big_integer::big_integer(double a) : sign(false) {
+    big_integer res = from_floating(a);
+    swap(res);
+}
 
-uint32_t get_trial(const uint32_t a, const uint32_t b, const uint32_t c) {
-    uint64_t res = a;
-    res = ((res << BASE_ARRAY) + b) / c;
-    if (res > 0xffffffff) res = 0xffffffff;
-    return toUint32(res);
+big_integer::big_integer(long double a) : sign(false) {
+    big_integer res = from_floating(a);
+    swap(res);
 }
 
-void sub_equal_vectors(fast_vector &a, fast_vector const &b) {
-    uint64_t sum = toUint64(~b[0]) + toUint64(a[0]) + 1LL, carry = sum >> BASE_ARRAY;
-    a[0] = toUint32(sum);
-    for (size_t i = 1; i < b.size(); i++) {
-        sum = toUint64(~b[i]) + toUint64(a[i]) + carry;
-        a[i] = toUint32(sum);
-        carry = sum >> BASE_ARRAY;
-    }
+bool big_integer::fits_int64() const {
+    return size() < 2 || (size() == 2 && (array[1] >> (BASE_ARRAY - 1)) == uint32_t(sign));
 }
 
-bool compare_equal_vectors(fast_vector const &a, fast_vector const &b) {
-    for (size_t i = a.size(); i > 0; i--) {
-        if (a[i - 1] != b[i - 1]) return a[i - 1] < b[i - 1];
-    }
-    return 0;
+bool big_integer::fits_uint64() const {
+    return !sign && size() <= 2;
 }
 
+int64_t big_integer::to_int64() const {
+    if (!fits_int64()) throw runtime_error("value does not fit in int64_t");
+    return static_cast<int64_t>(get_digit(0) | toUint64(get_digit(1)) << BASE_ARRAY);
+}
 
+uint64_t big_integer::to_uint64() const {
+    if (!fits_uint64()) throw runtime_error("value does not fit in uint64_t");
+    return get_digit(0) | toUint64(get_digit(1)) << BASE_ARRAY;
+}
 
-big_integer operator/(big_integer const &a, big_integer const &b) {
-    if (b.is_zero()){
-        //throw runtime_error("can't divide by zero");
-        cout << "zero division was missed";
-        return big_integer(0);
+// The 64 bits of |this| from bit s on form an integer m below 2^64 that the conversion rounds
+// to 53 bits; a set bit below s only has to break ties, which its lowest bit does as well.
+// For a negative this, |this| = ~this + 1 carries into no limb above the lowest nonzero one
+// and negates that.
+double big_integer::to_double() const {
+    if (is_zero()) return 0;
+    size_t bits = bit_length();
+    if (bits > 1024) return sign ? -HUGE_VAL : HUGE_VAL;
+    size_t zeros = count_trailing_zeros(), low = zeros / BASE_ARRAY;
+    size_t s = bits > 64 ? bits - 64 : 0, k = s / BASE_ARRAY;
+    unsigned r = s % BASE_ARRAY;
+    uint32_t d[3];
+    for (size_t j = 0; j < 3; j++) {
+        size_t i = k + j;
+        uint32_t x = get_digit(i);
+        d[j] = !sign ? x : i < low ? 0 : i == low ? 0 - x : ~x;
     }
-    big_integer apos(a.abs());
-    big_integer bpos(b.abs());
-    
-    uint32_t f = toUint32((uint64_t(0xffffffff) + 1) / (uint64_t(bpos.array.back()) + 1));
-    size_t n = apos.size();
-    size_t m = bpos.size();
-    apos.array.prepare_to_new();
-    bpos.array.prepare_to_new();
-    apos.array = mul_big_small(apos.array, f);
-    bpos.array = mul_big_small(bpos.array, f);
-    apos.delete_zero();
-    bpos.delete_zero();
-
-    uint32_t last = bpos.array.back();
-    fast_vector temp(n - m + 1);
-    fast_vector dev(m + 1);
-    fast_vector div(m + 1);
-    for (size_t i = 0; i < m; i++) {
-        dev[i] = apos.get_real_digit(n + i - m);
+    uint64_t m = (d[0] | toUint64(d[1]) << BASE_ARRAY) >> r;
+    if (r != 0) m |= toUint64(d[2]) << (64 - r);
+    if (zeros < s) m |= 1;
+    double res = std::ldexp(static_cast<double>(m), int(s));
+    return sign ? -res : res;
+}
+
+big_integer::big_integer(string const &str) : sign(false) {
+    size_t begin = (!str.empty() && str[0] == '-') ? 1 : 0;
+    for (size_t i = begin; i < str.size(); i++) {
+        if (str[i] < '0' || str[i] > '9') throw runtime_error("symbol " + str.substr(i, 1) + " not correct");
     }
-    dev[m] = apos.get_digit(n);
-
-    for (size_t i = 0; i < n - m + 1; i++) {
-        dev[0] = apos.get_real_digit(n - m - i);
-        uint32_t tq = get_trial(dev[m], dev[m - 1], last);
-        div = mul_big_small(bpos.array, tq);
-        if (bpos.size() != 1) {
-            while ((tq >= 0) && compare_equal_vectors(dev, div)) {
-                div = mul_big_small(bpos.array, --tq);
-            }
-        }
-        sub_equal_vectors(dev, div);
-        for (size_t j = m; j > 0; j--) {
-            dev[j] = dev[j - 1];
-        }
-        temp[n - m - i] = tq;
+    vector<uint32_t> mag = limbs_from_decimal(str.data() + begin, str.size() - begin);
+    big_integer res = from_magnitude(begin == 1, mag.data(), mag.size());
+    swap(res);
+}
+
+void big_integer::divmod(big_integer const &a, big_integer const &b, big_integer &q, big_integer &r) {
+    if (b.is_zero()) throw runtime_error("division by zero");
+    fast_vector const am = a.magnitude(), bm = b.magnitude();
+    size_t an = am.size(), bn = bm.size();
+    if (an < bn) {
+        q = 0;
+        r = a;
+        return;
     }
-    big_integer res(a.sign ^ b.sign, temp);
-    res.correct();
-    return res;
+    fast_vector qv(an - bn + 1), rv(bn);
+    limbs_divrem(qv.data(), rv.data(), am.data(), an, bm.data(), bn);
+    q = from_magnitude(a.sign ^ b.sign, qv.data(), qv.size());
+    r = from_magnitude(a.sign, rv.data(), rv.size());
+}
+
+big_integer operator/(big_integer const &a, big_integer const &b) {
+    big_integer q, r;
+    big_integer::divmod(a, b, q, r);
+    return q;
 }
 
 big_integer operator%(big_integer const &a, big_integer const& b) {
-    return a - (a / b) * b;
+    big_integer q, r;
+    big_integer::divmod(a, b, q, r);
+    return r;
+}
+
+
+// -this in place: ~x + 1, where only -(-2^32n) = 2^32n needs a limb more
+void big_integer::negate_in_place() {
+    if (is_zero()) return;
+    size_t n = size();
+    array.prepare_to_new(n + 1);
+    uint32_t *data = array.data();
+    limbs_not(data, data, n);
+    size_t i = 0;
+    while (i < n && ++data[i] == 0) i++;
+    sign = !sign;
+    if (i == n && !sign) array.push_back(1);
+    delete_zero();
 }
 
+// The sum is worked out on max(n, 2) + 1 limbs, the top one fill, so that it cannot overflow:
+// with a carry out of them a negative number has become nonnegative, and with a borrow a
+// nonnegative one negative.
+void big_integer::add_small(bool negative, uint64_t magnitude) {
+    if (magnitude == 0) return;
+    size_t n = size(), m = max(n, size_t(2)) + 1;
+    array.prepare_to_new(m);
+    array.resize(m);
+    uint32_t *data = array.data();
+    if (sign) memset(data + n, 0xff, (m - n) * sizeof(uint32_t));
+    uint64_t lo = toUint32(magnitude), hi = magnitude >> BASE_ARRAY;
+    if (!negative) {
+        uint64_t sum = data[0] + lo;
+        data[0] = toUint32(sum);
+        sum = (sum >> BASE_ARRAY) + data[1] + hi;
+        data[1] = toUint32(sum);
+        bool carry = sum >> BASE_ARRAY;
+        for (size_t i = 2; carry && i < m; i++) carry = ++data[i] == 0;
+        sign = sign && !carry;
+    } else {
+        uint64_t diff = data[0] - lo;
+        data[0] = toUint32(diff);
+        diff = data[1] - hi - ((diff >> BASE_ARRAY) & 1);
+        data[1] = toUint32(diff);
+        bool borrow = (diff >> BASE_ARRAY) & 1;
+        for (size_t i = 2; borrow && i < m; i++) borrow = data[i]-- == 0;
+        sign = sign || borrow;
+    }
+    delete_zero();
+}
+
+// A negative this = x - 2^32n times m < 2^32 is x m - m 2^32n, so the high limb of x m less m
+// is the top limb of the product, which stays negative.
+void big_integer::mul_small(bool negative, uint64_t magnitude) {
+    if (magnitude == 0 || is_zero()) {
+        *this = big_integer();
+        return;
+    }
+    if (magnitude > UINT32_MAX) {
+        *this = *this * big_integer(magnitude);
+    } else {
+        uint32_t m = toUint32(magnitude);
+        size_t n = size();
+        array.prepare_to_new(n + 1);
+        uint32_t high = n > 0 ? limbs_mul_1(array.data(), array.data(), n, m) : 0;
+        array.push_back(sign ? high - m : high);
+        delete_zero();
+    }
+    if (negative) negate_in_place();
+}
+
+// Truncating, as operator/ and operator%: the quotient of the magnitudes gets the sign of
+// the product, the remainder that of this.
+void big_integer::div_small(bool negative, uint64_t magnitude, bool remainder) {
+    if (magnitude == 0 || magnitude > UINT32_MAX) {
+        big_integer d(magnitude);
+        if (negative) d.negate_in_place();
+        *this = remainder ? *this % d : *this / d;
+        return;
+    }
+    bool was_negative = sign;
+    if (was_negative) negate_in_place();
+    size_t n = size();
+    array.prepare_to_new();
+    uint32_t r = n > 0 ? limbs_divrem_1(array.data(), array.data(), n, toUint32(magnitude)) : 0;
+    if (remainder) {
+        array.resize(1);
+        array[0] = r;
+    }
+    delete_zero();
+    if (was_negative != (negative && !remainder)) negate_in_place();
+}
 
 big_integer &big_integer::operator+=(big_integer const &b) {
     return *this = *this + b;
@@ -497,34 +750,53 @@ big_integer& big_integer::operator|=(big_integer const &b) {
     return *this = *this | b;
 }
 
-big_integer& big_integer::operator<<=(uint32_t b) {
-    return *this = *this << b;
+// The shifts in place move the limbs within the array, which only grows by the limbs that
+// come in at the bottom, and shift the bits within them in the same pass.
+big_integer& big_integer::operator<<=(uint64_t b) {
+    if (b == 0 || is_zero()) return *this;
+    size_t n = size();
+    size_t div = shift_limbs(b, n);
+    unsigned mod = b & (BASE_ARRAY - 1);
+    uint32_t ext = sign ? 0xffffffff : 0;
+    array.prepare_to_new(n + div + 1);
+    array.resize(n + div + 1);
+    uint32_t *data = array.data();
+    if (mod == 0) {
+        memmove(data + div, data, n * sizeof(uint32_t));
+        data[n + div] = ext;
+    } else {
+        uint32_t out = (n > 0) ? limbs_lshift(data + div, data, n, mod) : 0;
+        data[n + div] = (ext << mod) | out;
+    }
+    memset(data, 0, div * sizeof(uint32_t));
+    delete_zero();
+    return *this;
 }
 
-big_integer& big_integer::operator>>=(uint32_t b) {
-    return *this = *this >> b;
+big_integer& big_integer::operator>>=(uint64_t b) {
+    if (b == 0) return *this;
+    size_t div = (b >> 5) < size() ? static_cast<size_t>(b >> 5) : size();
+    unsigned mod = b & (BASE_ARRAY - 1);
+    size_t n = size() - div;
+    array.prepare_to_new();
+    if (n > 0) {
+        uint32_t *data = array.data();
+        if (mod == 0) {
+            memmove(data, data + div, n * sizeof(uint32_t));
+        } else {
+            limbs_rshift(data, data + div, n, mod);
+            data[n - 1] |= (sign ? 0xffffffff : 0) << (BASE_ARRAY - mod);
+        }
+    }
+    array.resize(n);
+    delete_zero();
+    return *this;
 }
 
 
 string to_string(big_integer const& a) {
-    if ((!a.sign) && (a.size() == 0)) return "0";
-    if (a.size() == 0 && (a.sign)) return "-1";
-    string ans = "";
-    big_integer apos(a.abs());
-    while (!apos.is_zero())
-    {
-        uint32_t temp = (apos % BASE_INT).get_digit(0);
-        for (size_t i = 0; i < 9; i++) {
-            ans.push_back('0' + temp % 10);
-            temp /= 10;
-        }
-        apos /= BASE_INT;
-    }
-    while (!ans.empty() && ans.back() == '0') {
-        ans.pop_back();
-    }
-    if (a.sign) ans.push_back('-');
-
-    reverse(ans.begin(), ans.end());
+    string ans = a.sign ? "-" : "";
+    fast_vector const mag = a.magnitude();
+    limbs_to_decimal(ans, mag.data(), mag.size());
     return ans;
-}
\ No newline at end of file
+}
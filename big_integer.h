@@ -4,8 +4,16 @@
 using namespace std;
 
 #include "optimized_vector.h"
+#include "thread_pool.h"
 #include <string>
+#include <cstdint>
 #include <cstdlib>
+#include <type_traits>
+
+// R, for a native integer type T only: the operators below that take one are picked over
+// converting it to a big_integer.
+template<typename T, typename R>
+using if_native = typename std::enable_if<std::is_integral<T>::value, R>::type;
 
 struct big_integer {
     big_integer();
@@ -13,23 +21,81 @@ struct big_integer {
     big_integer(int a);
     big_integer(uint32_t a);
     big_integer(uint64_t a);
+    big_integer(int64_t a);
     explicit big_integer(string const& str);
+    // the integer part, rounded towards zero; throws for infinities and NaN
+    explicit big_integer(double a);
+    explicit big_integer(long double a);
 
     big_integer& operator=(big_integer const& other);
 
     big_integer abs() const;
+    // bits of |this|, 0 for 0; looks at the top limbs only, and for a negative number also
+    // at the low limbs up to the first nonzero one
+    size_t bit_length() const;
+    // floor(log2(this)) for this > 0, throws otherwise
+    size_t ilog2() const;
+    // Native values from the low two limbs; to_int64 and to_uint64 throw if the value does not
+    // fit. to_double rounds to nearest, ties to even, from the top 64 bits of |this| and
+    // whether any bit below them is set; it is infinite beyond the range of double.
+    bool fits_int64() const;
+    bool fits_uint64() const;
+    int64_t to_int64() const;
+    uint64_t to_uint64() const;
+    double to_double() const;
+    // Single bits in two's complement, so that a negative number has ones from some point on;
+    // they touch the limb of the bit only, unless set_bit or clear_bit go beyond the stored
+    // limbs. Counts and positions that would be infinite are SIZE_MAX: popcount of a negative
+    // number, count_trailing_zeros of 0, scan1 past the top of a nonnegative number and scan0
+    // past the top of a negative one.
+    bool test_bit(size_t k) const;
+    void set_bit(size_t k);
+    void clear_bit(size_t k);
+    void flip_bit(size_t k);
+    size_t popcount() const;
+    size_t count_trailing_zeros() const;
+    // the least position >= from of a one or a zero bit
+    size_t scan1(size_t from) const;
+    size_t scan0(size_t from) const;
+    // this^n, with 0^0 = 1
+    big_integer pow(uint64_t n) const;
     big_integer& operator+=(big_integer const& rhs);
     big_integer& operator-=(big_integer const& rhs);
     big_integer& operator*=(big_integer const& rhs);
     big_integer& operator/=(big_integer const& rhs);
     big_integer& operator%=(big_integer const& rhs);
 
+    // With a native integer the compound operators work in place: += and -= carry into the
+    // limbs above the low two only as far as the carry goes, *=, /= and %= by one limb are a
+    // single pass of limbs_mul_1 or limbs_divrem_1. Longer factors and divisors, and 0,
+    // go through the big_integer operators.
+    template<typename T> if_native<T, big_integer&> operator+=(T rhs) {
+        add_small(native_negative(rhs), native_magnitude(rhs));
+        return *this;
+    }
+    template<typename T> if_native<T, big_integer&> operator-=(T rhs) {
+        add_small(!native_negative(rhs), native_magnitude(rhs));
+        return *this;
+    }
+    template<typename T> if_native<T, big_integer&> operator*=(T rhs) {
+        mul_small(native_negative(rhs), native_magnitude(rhs));
+        return *this;
+    }
+    template<typename T> if_native<T, big_integer&> operator/=(T rhs) {
+        div_small(native_negative(rhs), native_magnitude(rhs), false);
+        return *this;
+    }
+    template<typename T> if_native<T, big_integer&> operator%=(T rhs) {
+        div_small(native_negative(rhs), native_magnitude(rhs), true);
+        return *this;
+    }
+
     big_integer& operator&=(big_integer const& rhs);
     big_integer& operator|=(big_integer const& rhs);
     big_integer& operator^=(big_integer const& rhs);
 
-    big_integer& operator<<=(uint32_t rhs);
-    big_integer& operator>>=(uint32_t rhs);
+    big_integer& operator<<=(uint64_t rhs);
+    big_integer& operator>>=(uint64_t rhs);
 
     big_integer operator+() const;
     big_integer operator-() const;
@@ -41,6 +107,12 @@ struct big_integer {
     big_integer& operator--();
     big_integer operator--(int);
 
+    // -1, 0 or 1 as a < b, a == b or a > b; native integers are compared limb by limb as
+    // they are, without a big_integer made of them
+    friend int compare(big_integer const& a, big_integer const& b);
+    friend int compare(big_integer const& a, int64_t b);
+    friend int compare(big_integer const& a, uint64_t b);
+
     friend bool operator==(big_integer const& a, big_integer const& b);
     friend bool operator!=(big_integer const& a, big_integer const& b);
     friend bool operator<(big_integer const& a, big_integer const& b);
@@ -57,14 +129,24 @@ struct big_integer {
     friend big_integer operator&(big_integer const &a, big_integer const& b);
     friend big_integer operator|(big_integer const &a, big_integer const& b);
     friend big_integer operator^(big_integer const &a, big_integer const& b);
-    friend big_integer operator<<(big_integer const &a, uint32_t b);
-    friend big_integer operator>>(big_integer const &a, uint32_t b);
+    friend big_integer operator<<(big_integer const &a, uint64_t b);
+    friend big_integer operator>>(big_integer const &a, uint64_t b);
+    // the number of bits in which a and b differ, SIZE_MAX if their signs do; popcount(a ^ b)
+    // without computing a ^ b
+    friend size_t hamming_distance(big_integer const& a, big_integer const& b);
 
     friend string to_string(big_integer const& a);
+    friend big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& m);
+    friend struct montgomery_context;
+    friend struct barrett_reducer;
+
     void swap(big_integer &other) noexcept;
     bool is_zero() const;
     bool is_negative() const;
     big_integer(bool new_sign, fast_vector const &new_data);
+    // |this| as limbs, possibly with zero limbs on top, and the inverse
+    fast_vector magnitude() const;
+    static big_integer from_magnitude(bool negative, uint32_t const *mag, size_t n);
 private:
     bool sign;
     fast_vector array;
@@ -72,11 +154,96 @@ private:
     uint32_t get_digit(size_t ind) const;
     uint32_t get_real_digit(size_t ind) const;
     void delete_zero();
+    void add_small(bool negative, uint64_t magnitude);
+    void mul_small(bool negative, uint64_t magnitude);
+    void div_small(bool negative, uint64_t magnitude, bool remainder);
+    void negate_in_place();
+    template<typename T> static bool native_negative(T a) {
+        return a < T();
+    }
+    // |a| for any native a, INT64_MIN included
+    template<typename T> static uint64_t native_magnitude(T a) {
+        return a < T() ? 0 - static_cast<uint64_t>(a) : static_cast<uint64_t>(a);
+    }
+    void put_bit(size_t k, bool value);
+    size_t scan(size_t from, uint32_t fill) const;
     void correct();
     big_integer negate() ;
-    big_integer dividebi(uint32_t rhs);
-    big_integer dividebi(big_integer const &rhs);
+    static void divmod(big_integer const &a, big_integer const &b, big_integer &q, big_integer &r);
 };
 
+size_t hamming_distance(big_integer const& a, big_integer const& b);
+
+template<typename T> if_native<T, int> compare(big_integer const& a, T b) {
+    return std::is_signed<T>::value ? compare(a, static_cast<int64_t>(b)) : compare(a, static_cast<uint64_t>(b));
+}
+
+template<typename T> if_native<T, big_integer> operator+(big_integer a, T b) {
+    return a += b;
+}
+template<typename T> if_native<T, big_integer> operator+(T a, big_integer b) {
+    return b += a;
+}
+template<typename T> if_native<T, big_integer> operator-(big_integer a, T b) {
+    return a -= b;
+}
+template<typename T> if_native<T, big_integer> operator-(T a, big_integer const& b) {
+    return -b += a;
+}
+template<typename T> if_native<T, big_integer> operator*(big_integer a, T b) {
+    return a *= b;
+}
+template<typename T> if_native<T, big_integer> operator*(T a, big_integer b) {
+    return b *= a;
+}
+template<typename T> if_native<T, big_integer> operator/(big_integer a, T b) {
+    return a /= b;
+}
+template<typename T> if_native<T, big_integer> operator/(T a, big_integer const& b) {
+    return (big_integer() += a) /= b;
+}
+template<typename T> if_native<T, big_integer> operator%(big_integer a, T b) {
+    return a %= b;
+}
+template<typename T> if_native<T, big_integer> operator%(T a, big_integer const& b) {
+    return (big_integer() += a) %= b;
+}
+
+template<typename T> if_native<T, bool> operator==(big_integer const& a, T b) {
+    return compare(a, b) == 0;
+}
+template<typename T> if_native<T, bool> operator!=(big_integer const& a, T b) {
+    return compare(a, b) != 0;
+}
+template<typename T> if_native<T, bool> operator<(big_integer const& a, T b) {
+    return compare(a, b) < 0;
+}
+template<typename T> if_native<T, bool> operator>(big_integer const& a, T b) {
+    return compare(a, b) > 0;
+}
+template<typename T> if_native<T, bool> operator<=(big_integer const& a, T b) {
+    return compare(a, b) <= 0;
+}
+template<typename T> if_native<T, bool> operator>=(big_integer const& a, T b) {
+    return compare(a, b) >= 0;
+}
+template<typename T> if_native<T, bool> operator==(T a, big_integer const& b) {
+    return compare(b, a) == 0;
+}
+template<typename T> if_native<T, bool> operator!=(T a, big_integer const& b) {
+    return compare(b, a) != 0;
+}
+template<typename T> if_native<T, bool> operator<(T a, big_integer const& b) {
+    return compare(b, a) > 0;
+}
+template<typename T> if_native<T, bool> operator>(T a, big_integer const& b) {
+    return compare(b, a) < 0;
+}
+template<typename T> if_native<T, bool> operator<=(T a, big_integer const& b) {
+    return compare(b, a) >= 0;
+}
+template<typename T> if_native<T, bool> operator>=(T a, big_integer const& b) {
+    return compare(b, a) <= 0;
+}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,873 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "big_integer.h"
+#include "limb_kernels.h"
+#include "modular.h"
+#include "number_theory.h"
+#include "product_tree.h"
+
+namespace
+{
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void bench_conversion(size_t digits, size_t max_threads)
+{
+    std::mt19937 rng(12345);
+    std::string text(1, static_cast<char>('1' + rng() % 9));
+    for (size_t i = 1; i != digits; ++i)
+        text.push_back(static_cast<char>('0' + rng() % 10));
+
+    std::vector<size_t> counts;
+    for (size_t t = 1; t < max_threads; t *= 2)
+        counts.push_back(t);
+    counts.push_back(max_threads);
+
+    std::printf("decimal conversion, %zu digits\n", digits);
+    std::printf("%8s %12s %9s %12s %9s\n", "threads", "parse, s", "speedup", "to_string, s", "speedup");
+    double parse_base = 0, print_base = 0;
+    for (size_t i = 0; i != counts.size(); ++i) {
+        set_thread_count(counts[i]);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        big_integer value(text);
+        double parse = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        std::string back = to_string(value);
+        double print = seconds_since(start);
+
+        if (back != text) {
+            std::printf("round trip mismatch with %zu threads\n", counts[i]);
+            std::exit(1);
+        }
+        if (i == 0) {
+            parse_base = parse;
+            print_base = print;
+        }
+        std::printf("%8zu %12.3f %8.2fx %12.3f %8.2fx\n", counts[i], parse, parse_base / parse, print,
+                    print_base / print);
+    }
+    set_thread_count(1);
+}
+
+big_integer random_bits(std::mt19937& rng, size_t bits)
+{
+    big_integer result = 0;
+    for (size_t i = 0; i < bits; i += 32)
+        result = (result << 32) + big_integer(static_cast<uint32_t>(rng()));
+    return result >> ((bits + 31) / 32 * 32 - bits);
+}
+
+// square-and-multiply with operator* and operator%, the way powmod used to be written by hand
+big_integer naive_powmod(big_integer base, big_integer exp, big_integer const& mod)
+{
+    big_integer result = 1;
+    base %= mod;
+    while (!exp.is_zero()) {
+        if ((exp & 1) == 1)
+            result = result * base % mod;
+        base = base * base % mod;
+        exp >>= 1;
+    }
+    return result;
+}
+
+void bench_powmod()
+{
+    std::mt19937 rng(54321);
+    std::printf("modular exponentiation, full-size exponent\n");
+    std::printf("%6s %6s %12s %12s %9s\n", "bits", "mod", "naive, ms", "powmod, ms", "speedup");
+    size_t const sizes[] = {1024, 2048, 4096};
+    for (size_t i = 0; i != 3; ++i) {
+        for (int odd = 1; odd >= 0; --odd) {
+            big_integer mod = random_bits(rng, sizes[i]) | (big_integer(1) << (sizes[i] - 1));
+            mod = odd ? (mod | 1) : (mod & ~big_integer(1));
+            big_integer base = random_bits(rng, sizes[i]) % mod;
+            big_integer exp = random_bits(rng, sizes[i]);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            big_integer expected = naive_powmod(base, exp, mod);
+            double naive = seconds_since(start);
+
+            start = std::chrono::steady_clock::now();
+            big_integer fast = powmod(base, exp, mod);
+            double elapsed = seconds_since(start);
+
+            if (fast != expected) {
+                std::printf("powmod mismatch at %zu bits\n", sizes[i]);
+                std::exit(1);
+            }
+            std::printf("%6zu %6s %12.2f %12.2f %8.2fx\n", sizes[i], odd ? "odd" : "even", naive * 1000,
+                        elapsed * 1000, naive / elapsed);
+        }
+    }
+}
+
+void bench_reduction()
+{
+    std::mt19937 rng(777);
+    size_t const count = 20000;
+    std::printf("reduction of %zu double-width values by a fixed modulus\n", count);
+    std::printf("%6s %12s %12s %9s\n", "bits", "%, ms", "barrett, ms", "speedup");
+    size_t const sizes[] = {256, 1024, 2048, 4096};
+    for (size_t i = 0; i != 4; ++i) {
+        big_integer mod = random_bits(rng, sizes[i]) | (big_integer(1) << (sizes[i] - 1));
+        std::vector<big_integer> values;
+        for (size_t j = 0; j != count; ++j)
+            values.push_back(random_bits(rng, 2 * sizes[i]) % (mod * mod));
+        barrett_reducer reducer(mod);
+
+        big_integer sum_naive = 0, sum_fast = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t j = 0; j != count; ++j)
+            sum_naive += values[j] % mod;
+        double naive = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        for (size_t j = 0; j != count; ++j)
+            sum_fast += reducer.reduce(values[j]);
+        double elapsed = seconds_since(start);
+
+        if (sum_fast != sum_naive) {
+            std::printf("barrett mismatch at %zu bits\n", sizes[i]);
+            std::exit(1);
+        }
+        std::printf("%6zu %12.2f %12.2f %8.2fx\n", sizes[i], naive * 1000, elapsed * 1000, naive / elapsed);
+    }
+}
+
+// right-to-left square-and-multiply with operator*, as hand-written before pow existed
+big_integer naive_pow(big_integer base, uint64_t n)
+{
+    big_integer result = 1;
+    for (; n != 0; n >>= 1) {
+        if (n & 1)
+            result *= base;
+        if (n > 1)
+            base *= base;
+    }
+    return result;
+}
+
+void bench_pow()
+{
+    std::printf("powers\n");
+    std::printf("%12s %10s %12s %12s %9s\n", "base", "exponent", "naive, ms", "pow, ms", "speedup");
+    int const bases[] = {3, 10, 96, 1 << 20};
+    uint64_t const exponents[] = {1000000, 1000000, 300000, 1000000};
+    for (size_t i = 0; i != 4; ++i) {
+        big_integer base(bases[i]);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        big_integer expected = naive_pow(base, exponents[i]);
+        double naive = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        big_integer fast = base.pow(exponents[i]);
+        double elapsed = seconds_since(start);
+
+        if (fast != expected) {
+            std::printf("pow mismatch for %d^%llu\n", bases[i], static_cast<unsigned long long>(exponents[i]));
+            std::exit(1);
+        }
+        std::printf("%12d %10llu %12.2f %12.2f %8.2fx\n", bases[i], static_cast<unsigned long long>(exponents[i]),
+                    naive * 1000, elapsed * 1000, naive / elapsed);
+    }
+}
+
+void bench_gcd()
+{
+    std::mt19937 rng(4242);
+    std::printf("gcd of random numbers\n");
+    std::printf("%8s %12s %12s %9s\n", "limbs", "euclid, ms", "gcd, ms", "speedup");
+    size_t const sizes[] = {100, 1000, 4000, 16000};
+    for (size_t i = 0; i != 4; ++i) {
+        big_integer a = random_bits(rng, 32 * sizes[i]), b = random_bits(rng, 32 * sizes[i]);
+        double naive = 0;
+        big_integer expected;
+        if (sizes[i] <= 4000) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            big_integer x = a, y = b;
+            while (!y.is_zero()) {
+                big_integer r = x % y;
+                x = y;
+                y = r;
+            }
+            naive = seconds_since(start);
+            expected = x;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        big_integer g = gcd(a, b);
+        double elapsed = seconds_since(start);
+
+        if (naive == 0) {
+            std::printf("%8zu %12s %12.2f %9s\n", sizes[i], "-", elapsed * 1000, "-");
+            continue;
+        }
+        if (g != expected) {
+            std::printf("gcd mismatch at %zu limbs\n", sizes[i]);
+            std::exit(1);
+        }
+        std::printf("%8zu %12.2f %12.2f %8.2fx\n", sizes[i], naive * 1000, elapsed * 1000, naive / elapsed);
+    }
+}
+
+void bench_modinv()
+{
+    std::mt19937 rng(77);
+    big_integer p = (big_integer(1) << 1279) - 1;
+    std::vector<big_integer> values;
+    for (size_t i = 0; i != 1000; ++i)
+        values.push_back(random_bits(rng, 1279));
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<big_integer> single;
+    for (size_t i = 0; i != values.size(); ++i)
+        single.push_back(modinv(values[i], p));
+    double naive = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<big_integer> batch = batch_modinv(values, p);
+    double elapsed = seconds_since(start);
+
+    if (batch != single) {
+        std::printf("batch_modinv mismatch\n");
+        std::exit(1);
+    }
+    std::printf("1000 inverses mod 2^1279 - 1: modinv %.2f ms, batch_modinv %.2f ms, %.2fx\n",
+                naive * 1000, elapsed * 1000, naive / elapsed);
+}
+
+void bench_jacobi()
+{
+    std::mt19937 rng(4343);
+    std::printf("jacobi symbol\n");
+    std::printf("%8s %12s %12s %9s %12s\n", "limbs", "naive, ms", "jacobi, ms", "speedup", "gcd, ms");
+    size_t const sizes[] = {100, 1000, 4000, 16000};
+    for (size_t i = 0; i != 4; ++i) {
+        big_integer n = random_bits(rng, 32 * sizes[i]) | 1, a = random_bits(rng, 32 * sizes[i]);
+        double naive = 0;
+        int expected = 0;
+        if (sizes[i] <= 4000) {
+            // twos pulled out by shifts, reciprocity by operator%
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            big_integer x = a % n, y = n;
+            int res = 1;
+            while (!x.is_zero()) {
+                while ((x & 1) == 0) {
+                    x >>= 1;
+                    big_integer r = y & 7;
+                    if (r == 3 || r == 5) res = -res;
+                }
+                if ((x & 3) == 3 && (y & 3) == 3) res = -res;
+                big_integer r = y % x;
+                y = x;
+                x = r;
+            }
+            naive = seconds_since(start);
+            expected = (y == 1) ? res : 0;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int j = jacobi(a, n);
+        double elapsed = seconds_since(start);
+        start = std::chrono::steady_clock::now();
+        gcd(a, n);
+        double g = seconds_since(start);
+
+        if (naive == 0) {
+            std::printf("%8zu %12s %12.2f %9s %12.2f\n", sizes[i], "-", elapsed * 1000, "-", g * 1000);
+            continue;
+        }
+        if (j != expected) {
+            std::printf("jacobi mismatch at %zu limbs\n", sizes[i]);
+            std::exit(1);
+        }
+        std::printf("%8zu %12.2f %12.2f %8.2fx %12.2f\n", sizes[i], naive * 1000, elapsed * 1000, naive / elapsed,
+                    g * 1000);
+    }
+}
+
+void bench_roots()
+{
+    std::mt19937 rng(99);
+    std::printf("square root\n");
+    std::printf("%8s %12s %12s %9s %12s\n", "limbs", "newton, ms", "sqrtrem, ms", "speedup", "cbrt, ms");
+    size_t const sizes[] = {1000, 10000};
+    for (size_t i = 0; i != 2; ++i) {
+        big_integer a = random_bits(rng, 32 * sizes[i]);
+
+        // Newton's iteration at full size, starting above the root
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        big_integer x = big_integer(1) << (16 * sizes[i] + 1);
+        for (;;) {
+            big_integer y = (x + a / x) >> 1;
+            if (y >= x)
+                break;
+            x = y;
+        }
+        double naive = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        sqrtrem_result r = sqrtrem(a);
+        double elapsed = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        big_integer c = iroot(a, 3);
+        double cbrt = seconds_since(start);
+
+        if (r.s != x || r.s * r.s + r.r != a || c.pow(3) > a) {
+            std::printf("root mismatch at %zu limbs\n", sizes[i]);
+            std::exit(1);
+        }
+        std::printf("%8zu %12.2f %12.2f %8.2fx %12.2f\n", sizes[i], naive * 1000, elapsed * 1000, naive / elapsed, cbrt * 1000);
+    }
+}
+
+void bench_powers()
+{
+    std::mt19937 rng(515);
+    big_integer a = random_bits(rng, 32 * 1000);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t shifted = 0;
+    for (big_integer x = a; !x.is_zero(); x >>= 1) ++shifted;
+    double naive = seconds_since(start);
+    start = std::chrono::steady_clock::now();
+    size_t bits = 0;
+    for (size_t i = 0; i != 1000; ++i) bits += a.bit_length();
+    double elapsed = seconds_since(start) / 1000;
+    if (bits != 1000 * shifted) {
+        std::printf("bit_length mismatch\n");
+        std::exit(1);
+    }
+    std::printf("bit length of 1000 limbs: shifting %.2f ms, bit_length %.1f ns\n", naive * 1000, elapsed * 1e9);
+
+    std::printf("perfect powers, numbers without small factors\n");
+    std::printf("%8s %12s %16s %9s %12s %9s\n", "limbs", "iroot, ms", "is_power, ms", "speedup", "divide, ms", "ilog, ms");
+    big_integer const small = primorial(SMALL_PRIME_BOUND);
+    size_t const sizes[] = {100, 1000, 10000};
+    for (size_t i = 0; i != 3; ++i) {
+        big_integer n = random_bits(rng, 32 * sizes[i]) | 1;
+        while (gcd(n, small) != 1) n += 2;
+
+        // iroot for every prime k that the length allows
+        naive = 0;
+        if (sizes[i] <= 1000) {
+            start = std::chrono::steady_clock::now();
+            for (unsigned k = 2; k <= 32 * sizes[i]; ++k) {
+                bool prime = true;
+                for (unsigned d = 2; d * d <= k && prime; ++d) prime = k % d != 0;
+                if (prime && iroot(n, k).pow(k) == n) {
+                    std::printf("random number is a power?\n");
+                    std::exit(1);
+                }
+            }
+            naive = seconds_since(start);
+        }
+
+        start = std::chrono::steady_clock::now();
+        bool power = is_perfect_power(n);
+        elapsed = seconds_since(start);
+
+        // decimal digits by dividing by 10 until nothing is left
+        start = std::chrono::steady_clock::now();
+        size_t digits = 0;
+        for (big_integer x = n; !x.is_zero(); x /= 10) ++digits;
+        double divide = seconds_since(start);
+        start = std::chrono::steady_clock::now();
+        size_t e = ilog(n, 10);
+        double log = seconds_since(start);
+
+        if (power || e + 1 != digits) {
+            std::printf("perfect power mismatch at %zu limbs\n", sizes[i]);
+            std::exit(1);
+        }
+        if (naive == 0)
+            std::printf("%8zu %12s %16.2f %9s %12.2f %9.3f\n", sizes[i], "-", elapsed * 1000, "-", divide * 1000, log * 1000);
+        else
+            std::printf("%8zu %12.2f %16.2f %8.2fx %12.2f %9.3f\n", sizes[i], naive * 1000, elapsed * 1000,
+                        naive / elapsed, divide * 1000, log * 1000);
+    }
+}
+
+void bench_bits()
+{
+    std::mt19937 rng(516);
+    std::printf("single bits of a number of that many limbs, per operation\n");
+    std::printf("%8s %14s %14s %14s %14s\n", "limbs", "shift-or, us", "set_bit, ns", "shift-and, us", "test_bit, ns");
+    size_t const sizes[] = {100, 1000, 10000};
+    for (size_t i = 0; i != 3; ++i) {
+        big_integer a = random_bits(rng, 32 * sizes[i]), b = a;
+        size_t const reps = 100;
+        std::vector<uint32_t> pos(reps);
+        for (size_t j = 0; j != reps; ++j) pos[j] = rng() % (32 * sizes[i] + 64);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t naive_ones = 0;
+        for (size_t j = 0; j != reps; ++j) naive_ones += !((a >> pos[j]) & 1).is_zero();
+        double naive_test = seconds_since(start) / reps;
+        start = std::chrono::steady_clock::now();
+        for (size_t j = 0; j != reps; ++j) a |= big_integer(1) << pos[j];
+        double naive_set = seconds_since(start) / reps;
+
+        size_t const fast_reps = 100000;
+        start = std::chrono::steady_clock::now();
+        size_t ones = 0;
+        for (size_t j = 0; j != fast_reps; ++j) ones += b.test_bit(pos[j % reps]);
+        double test = seconds_since(start) / fast_reps;
+        start = std::chrono::steady_clock::now();
+        for (size_t j = 0; j != fast_reps; ++j) b.set_bit(pos[j % reps]);
+        double set = seconds_since(start) / fast_reps;
+
+        if (a != b || ones != naive_ones * (fast_reps / reps)) {
+            std::printf("bit mismatch at %zu limbs\n", sizes[i]);
+            std::exit(1);
+        }
+        std::printf("%8zu %14.2f %14.1f %14.2f %14.1f\n", sizes[i], naive_set * 1e6, set * 1e9, naive_test * 1e6,
+                    test * 1e9);
+    }
+}
+
+void bench_shifts()
+{
+    std::mt19937 rng(518);
+    std::printf("shifts by 37 bits up and down, per pair\n");
+    std::printf("%8s %14s %14s %9s\n", "limbs", "copying, us", "in place, us", "speedup");
+    size_t const sizes[] = {100, 1000, 10000, 100000};
+    for (size_t i = 0; i != 4; ++i) {
+        big_integer const a = random_bits(rng, 32 * sizes[i]);
+        size_t const reps = 10000000 / sizes[i];
+        big_integer x = a, y = a;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r != reps; ++r) {
+            x = x << 37;
+            x = x >> 37;
+        }
+        double copying = seconds_since(start) / reps;
+        start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r != reps; ++r) {
+            y <<= 37;
+            y >>= 37;
+        }
+        double in_place = seconds_since(start) / reps;
+
+        if (x != a || y != a) {
+            std::printf("shift mismatch at %zu limbs\n", sizes[i]);
+            std::exit(1);
+        }
+        std::printf("%8zu %14.2f %14.2f %8.2fx\n", sizes[i], copying * 1e6, in_place * 1e6, copying / in_place);
+    }
+}
+
+void bench_compare()
+{
+    std::mt19937 rng(519);
+    size_t const limbs = 10000, reps = 10000;
+    big_integer const a = random_bits(rng, 32 * limbs) | 1;
+    big_integer const top = a + (big_integer(1) << (32 * limbs - 8)), bottom = a - 1;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t less = 0;
+    for (size_t r = 0; r != reps; ++r) less += (a < top) + (top > a);
+    double differ_top = seconds_since(start) / (2 * reps);
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r != reps; ++r) less += (bottom < a) + (a > bottom);
+    double differ_bottom = seconds_since(start) / (2 * reps);
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r != reps; ++r) less += (a < big_integer(int(r)));
+    double converted = seconds_since(start) / reps;
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r != reps; ++r) less += (compare(a, int(r)) < 0);
+    double small = seconds_since(start) / reps;
+
+    if (less != 4 * reps) {
+        std::printf("comparison mismatch\n");
+        std::exit(1);
+    }
+    std::printf("comparisons of %zu limbs: differing at the top %.1f ns, at the bottom %.2f us; "
+                "with an int, converted %.1f ns, compare %.1f ns\n", limbs, differ_top * 1e9, differ_bottom * 1e6,
+                converted * 1e9, small * 1e9);
+}
+
+void bench_native()
+{
+    std::mt19937 rng(520);
+    std::printf("big by native int, per operation: converted to big_integer / native, ns\n");
+    std::printf("%8s %18s %18s %18s %18s %18s\n", "limbs", "x += 7", "x * 10", "x / 10", "x *= 3, x /= 3", "x == 0");
+    size_t const sizes[] = {4, 100, 1000};
+    for (size_t i = 0; i != 3; ++i) {
+        big_integer const a = random_bits(rng, 32 * sizes[i]);
+        size_t const reps = 4000000 / sizes[i];
+        double t[5][2];
+        big_integer x, y, r;
+        size_t zeros = 0;
+        for (int native = 0; native != 2; ++native) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            x = a;
+            for (size_t k = 0; k != reps; ++k) {
+                if (native) x += 7;
+                else x += big_integer(7);
+            }
+            t[0][native] = seconds_since(start) / reps;
+            start = std::chrono::steady_clock::now();
+            for (size_t k = 0; k != reps; ++k) r = native ? a * 10 : a * big_integer(10);
+            t[1][native] = seconds_since(start) / reps;
+            start = std::chrono::steady_clock::now();
+            for (size_t k = 0; k != reps; ++k) r = native ? a / 10 : a / big_integer(10);
+            t[2][native] = seconds_since(start) / reps;
+            start = std::chrono::steady_clock::now();
+            y = a;
+            for (size_t k = 0; k != reps; ++k) {
+                if (native) {
+                    y *= 3;
+                    y /= 3;
+                } else {
+                    y *= big_integer(3);
+                    y /= big_integer(3);
+                }
+            }
+            t[3][native] = seconds_since(start) / reps;
+            start = std::chrono::steady_clock::now();
+            for (size_t k = 0; k != reps; ++k) zeros += native ? x == 0 : x == big_integer(0);
+            t[4][native] = seconds_since(start) / reps;
+        }
+        if (x != a + 7 * reps || y != a || zeros != 0) {
+            std::printf("native operand mismatch at %zu limbs\n", sizes[i]);
+            std::exit(1);
+        }
+        std::printf("%8zu", sizes[i]);
+        for (int j = 0; j != 5; ++j) std::printf(" %9.1f / %6.1f", t[j][0] * 1e9, t[j][1] * 1e9);
+        std::printf("\n");
+    }
+}
+
+void bench_native_conversions()
+{
+    std::mt19937 rng(521);
+    size_t const reps = 100000;
+    std::vector<big_integer> small(reps);
+    for (size_t i = 0; i != reps; ++i) small[i] = random_bits(rng, 63) - (big_integer(1) << 62);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int64_t parsed = 0;
+    for (size_t i = 0; i != reps; ++i) parsed += std::stoll(to_string(small[i]));
+    double parsing = seconds_since(start) / reps;
+    start = std::chrono::steady_clock::now();
+    int64_t direct = 0;
+    for (size_t i = 0; i != reps; ++i) direct += small[i].to_int64();
+    double to_int = seconds_since(start) / reps;
+    if (parsed != direct) {
+        std::printf("to_int64 mismatch\n");
+        std::exit(1);
+    }
+    std::printf("int64 out of a big_integer: to_string and stoll %.1f ns, to_int64 %.1f ns\n", parsing * 1e9,
+                to_int * 1e9);
+
+    std::printf("%8s %22s %14s\n", "limbs", "to_string, strtod, us", "to_double, ns");
+    size_t const sizes[] = {10, 30};
+    for (size_t i = 0; i != 2; ++i) {
+        big_integer const a = -random_bits(rng, 32 * sizes[i]);
+        size_t const n = 10000;
+        start = std::chrono::steady_clock::now();
+        double d = 0;
+        for (size_t k = 0; k != n; ++k) d += std::strtod(to_string(a).c_str(), nullptr);
+        double naive = seconds_since(start) / n;
+        start = std::chrono::steady_clock::now();
+        double e = 0;
+        for (size_t k = 0; k != 100 * n; ++k) e += a.to_double();
+        double elapsed = seconds_since(start) / (100 * n);
+        if (a.to_double() != std::strtod(to_string(a).c_str(), nullptr) || d > 0 || e > 0) {
+            std::printf("to_double mismatch\n");
+            std::exit(1);
+        }
+        std::printf("%8zu %22.2f %14.1f\n", sizes[i], naive * 1e6, elapsed * 1e9);
+    }
+}
+
+void bench_hamming()
+{
+    std::mt19937 rng(517);
+    size_t const count = 200, bits = 1 << 16;
+    std::vector<big_integer> prints(count);
+    for (size_t i = 0; i != count; ++i) prints[i] = random_bits(rng, bits);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t naive = 0;
+    for (size_t i = 0; i + 1 < count; ++i) {
+        big_integer x = prints[i] ^ prints[i + 1];
+        for (size_t k = 0; k != bits; ++k) naive += x.test_bit(k);
+    }
+    double loop = seconds_since(start) / (count - 1);
+    start = std::chrono::steady_clock::now();
+    size_t xored = 0;
+    for (size_t i = 0; i + 1 < count; ++i) xored += (prints[i] ^ prints[i + 1]).popcount();
+    double xor_popcount = seconds_since(start) / (count - 1);
+    size_t const reps = 50;
+    start = std::chrono::steady_clock::now();
+    size_t distance = 0;
+    for (size_t r = 0; r != reps; ++r) {
+        for (size_t i = 0; i + 1 < count; ++i) distance += hamming_distance(prints[i], prints[i + 1]);
+    }
+    double elapsed = seconds_since(start) / (reps * (count - 1));
+
+    if (naive != xored || distance != reps * naive) {
+        std::printf("hamming distance mismatch\n");
+        std::exit(1);
+    }
+    std::printf("hamming distance of 64k-bit numbers, %s kernels: xor and bit loop %.2f us, xor and popcount "
+                "%.2f us, hamming_distance %.3f us\n", active_kernels().name, loop * 1e6, xor_popcount * 1e6,
+                elapsed * 1e6);
+}
+
+void bench_primality()
+{
+    std::printf("primality of Mersenne primes\n");
+    std::printf("%8s %16s %18s %12s\n", "bits", "fermat(2), ms", "bpsw + 5 mr, ms", "bpsw, ms");
+    unsigned const exponents[] = {1279, 2203, 4253};
+    for (size_t i = 0; i != 3; ++i) {
+        big_integer p = (big_integer(1) << exponents[i]) - 1;
+
+        // a single Fermat test to base 2 with operator%
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool fermat = naive_powmod(2, p - 1, p) == 1;
+        double naive = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        bool strong = is_probable_prime(p, 5);
+        double rounds = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        bool bpsw = is_probable_prime(p);
+        double elapsed = seconds_since(start);
+
+        if (!fermat || !strong || !bpsw) {
+            std::printf("2^%u - 1 is not prime?\n", exponents[i]);
+            std::exit(1);
+        }
+        std::printf("%8u %16.2f %18.2f %12.2f\n", exponents[i], naive * 1000, rounds * 1000, elapsed * 1000);
+    }
+}
+
+void bench_next_prime()
+{
+    std::mt19937 rng(2024);
+    std::printf("next prime after a random number\n");
+    std::printf("%8s %16s %16s %9s\n", "bits", "odd steps, ms", "next_prime, ms", "speedup");
+    size_t const sizes[] = {512, 1024, 2048};
+    for (size_t i = 0; i != 3; ++i) {
+        big_integer x = random_bits(rng, sizes[i]);
+
+        // is_probable_prime on every odd number in turn
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        big_integer expected = x + 1;
+        if ((expected & 1) == 0)
+            expected += 1;
+        while (!is_probable_prime(expected))
+            expected += 2;
+        double naive = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        big_integer p = next_prime(x);
+        double elapsed = seconds_since(start);
+
+        if (p != expected) {
+            std::printf("next_prime mismatch at %zu bits\n", sizes[i]);
+            std::exit(1);
+        }
+        std::printf("%8zu %16.2f %16.2f %8.2fx\n", sizes[i], naive * 1000, elapsed * 1000, naive / elapsed);
+    }
+}
+
+void bench_factorial()
+{
+    std::printf("factorial\n");
+    std::printf("%10s %12s %16s %9s\n", "n", "loop, ms", "factorial, ms", "speedup");
+    uint32_t const sizes[] = {10000, 50000, 1000000};
+    for (size_t i = 0; i != 3; ++i) {
+        // a running product with one small multiplier at a time
+        double naive = 0;
+        big_integer expected;
+        if (sizes[i] <= 50000) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            expected = 1;
+            for (uint32_t k = 2; k <= sizes[i]; ++k)
+                expected *= k;
+            naive = seconds_since(start);
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        big_integer f = factorial(sizes[i]);
+        double elapsed = seconds_since(start);
+
+        if (naive == 0) {
+            std::printf("%10u %12s %16.2f %9s\n", sizes[i], "-", elapsed * 1000, "-");
+            continue;
+        }
+        if (f != expected) {
+            std::printf("factorial mismatch at %u\n", sizes[i]);
+            std::exit(1);
+        }
+        std::printf("%10u %12.2f %16.2f %8.2fx\n", sizes[i], naive * 1000, elapsed * 1000, naive / elapsed);
+    }
+}
+
+void bench_fibonacci()
+{
+    std::printf("fibonacci\n");
+    std::printf("%10s %12s %16s %9s\n", "n", "loop, ms", "fibonacci, ms", "speedup");
+    uint32_t const sizes[] = {100000, 1000000, 10000000};
+    for (size_t i = 0; i != 3; ++i) {
+        // repeated additions
+        double naive = 0;
+        big_integer expected;
+        if (sizes[i] <= 100000) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            big_integer a = 0, b = 1;
+            for (uint32_t k = 0; k != sizes[i]; ++k) {
+                a += b;
+                a.swap(b);
+            }
+            expected = a;
+            naive = seconds_since(start);
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        big_integer f = fibonacci(sizes[i]);
+        double elapsed = seconds_since(start);
+
+        if (naive == 0) {
+            std::printf("%10u %12s %16.2f %9s\n", sizes[i], "-", elapsed * 1000, "-");
+            continue;
+        }
+        if (f != expected) {
+            std::printf("fibonacci mismatch at %u\n", sizes[i]);
+            std::exit(1);
+        }
+        std::printf("%10u %12.2f %16.2f %8.2fx\n", sizes[i], naive * 1000, elapsed * 1000, naive / elapsed);
+    }
+}
+
+void bench_trees()
+{
+    std::mt19937 rng(31337);
+    std::vector<big_integer> values;
+    for (size_t i = 0; i != 20000; ++i)
+        values.push_back(random_bits(rng, 64));
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    big_integer fold = 1;
+    for (size_t i = 0; i != values.size(); ++i)
+        fold *= values[i];
+    double naive = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    product_tree tree(values);
+    double elapsed = seconds_since(start);
+
+    if (tree.product() != fold) {
+        std::printf("product_tree mismatch\n");
+        std::exit(1);
+    }
+    std::printf("product of 20000 64-bit values: fold %.2f ms, product_tree %.2f ms, %.2fx\n",
+                naive * 1000, elapsed * 1000, naive / elapsed);
+
+    std::vector<big_integer> moduli;
+    for (size_t i = 0; i != 5000; ++i)
+        moduli.push_back(random_bits(rng, 32) + 1);
+    big_integer x = random_bits(rng, 32 * 20000);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<big_integer> expected;
+    for (size_t i = 0; i != moduli.size(); ++i)
+        expected.push_back(x % moduli[i]);
+    naive = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<big_integer> rem = remainder_tree(x, moduli);
+    elapsed = seconds_since(start);
+
+    if (rem != expected) {
+        std::printf("remainder_tree mismatch\n");
+        std::exit(1);
+    }
+    std::printf("20000 limbs mod 5000 32-bit moduli: operator%% %.2f ms, remainder_tree %.2f ms, %.2fx\n",
+                naive * 1000, elapsed * 1000, naive / elapsed);
+}
+
+void bench_crt()
+{
+    std::mt19937 rng(4711);
+    std::vector<big_integer> primes;
+    big_integer p = big_integer(1) << 31;
+    for (size_t i = 0; i != 4000; ++i)
+        primes.push_back(p = next_prime(p));
+    crt_context crt(primes);
+    big_integer x = random_bits(rng, 31 * 4000);
+    std::vector<big_integer> residues = remainder_tree(x, primes);
+
+    // incremental recombination: x = x + m ((r - x) / m mod p), m = m p
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    big_integer acc = 0, m = 1;
+    for (size_t i = 0; i != primes.size(); ++i) {
+        big_integer t = (residues[i] - acc) % primes[i] * modinv(m % primes[i], primes[i]) % primes[i];
+        if (t.is_negative())
+            t += primes[i];
+        acc += m * t;
+        m *= primes[i];
+    }
+    double naive = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    big_integer y = crt.reconstruct(residues);
+    double elapsed = seconds_since(start);
+
+    if (acc != x || y != x) {
+        std::printf("crt mismatch\n");
+        std::exit(1);
+    }
+    std::printf("crt over 4000 31-bit primes: incremental %.2f ms, crt_context %.2f ms, %.2fx\n",
+                naive * 1000, elapsed * 1000, naive / elapsed);
+}
+} // namespace
+
+// usage: big_integer_benchmark [digits] [max threads]
+int main(int argc, char *argv[])
+{
+    size_t digits = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t max_threads = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+    if (max_threads == 0)
+        max_threads = 1;
+
+    bench_conversion(digits, max_threads);
+    bench_powmod();
+    bench_reduction();
+    bench_pow();
+    bench_gcd();
+    bench_modinv();
+    bench_jacobi();
+    bench_roots();
+    bench_powers();
+    bench_bits();
+    bench_shifts();
+    bench_compare();
+    bench_native();
+    bench_native_conversions();
+    bench_hamming();
+    bench_primality();
+    bench_next_prime();
+    bench_factorial();
+    bench_fibonacci();
+    bench_trees();
+    bench_crt();
+    return 0;
+}
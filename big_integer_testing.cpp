@@ -1,11 +1,21 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "big_integer.h"
+#include "limb_kernels.h"
+#include "modular.h"
+#include "number_theory.h"
+#include "product_tree.h"
 
 TEST(correctness, two_plus_two)
 {
@@ -705,3 +715,1226 @@ TEST(correctness, div_randomized)
         EXPECT_LT(residue, divisor);
     }
 }
+
+namespace
+{
+big_integer rand_signed_big(size_t size)
+{
+    big_integer result = rand_big(size);
+    return (rand() % 2) ? -result : result;
+}
+} // namespace
+
+TEST(correctness, bitwise_long_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 10; ++itn) {
+        big_integer a = rand_signed_big(rand() % 60);
+        big_integer b = rand_signed_big(rand() % 60);
+        EXPECT_EQ((a ^ b) + ((a & b) << 1), a + b);
+        EXPECT_EQ(a | b, (a ^ b) + (a & b));
+        EXPECT_EQ(~(a & b), ~a | ~b);
+        EXPECT_EQ(a ^ b ^ b, a);
+    }
+}
+
+TEST(correctness, shift_long_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 10; ++itn) {
+        big_integer a = rand_signed_big(rand() % 60);
+        uint32_t k = rand() % 500;
+        big_integer pow2 = 1;
+        for (uint32_t i = 0; i != k; ++i)
+            pow2 *= 2;
+        EXPECT_EQ(a << k, a * pow2);
+        EXPECT_EQ((a << k) >> k, a);
+        EXPECT_EQ((a >> k) << k, a - (a & (pow2 - 1)));
+    }
+}
+
+TEST(correctness, compare_randomized)
+{
+    EXPECT_TRUE(big_integer(-1) != 0);
+    EXPECT_TRUE(big_integer(-1) < 0);
+    EXPECT_TRUE(-(big_integer(1) << 40) < -1);
+    EXPECT_TRUE(-(big_integer(1) << 64) < -(big_integer(1) << 64) + 1);
+    for (size_t itn = 0; itn != number_of_iterations * 10; ++itn) {
+        big_integer a = rand_signed_big(rand() % 4), b = rand() % 2 ? rand_signed_big(rand() % 4) : a + rand() % 3 - 1;
+        big_integer d = a - b;
+        int expected = d.is_negative() ? -1 : d.is_zero() ? 0 : 1;
+        EXPECT_EQ(compare(a, b), expected);
+        EXPECT_EQ(a < b, expected < 0);
+        EXPECT_EQ(a <= b, expected <= 0);
+        EXPECT_EQ(a == b, expected == 0);
+        EXPECT_EQ(a != b, expected != 0);
+        EXPECT_EQ(a >= b, expected >= 0);
+        EXPECT_EQ(a > b, expected > 0);
+    }
+
+    int64_t const small[] = {0, 1, -1, 5, -5, INT32_MAX, INT32_MIN, int64_t(UINT32_MAX), INT64_MAX, INT64_MIN};
+    for (int64_t x : small) {
+        big_integer const bx(std::to_string(x));
+        for (int64_t y : small) {
+            big_integer const by(std::to_string(y));
+            EXPECT_EQ(compare(bx, y), compare(bx, by));
+            if (y >= 0) {
+                EXPECT_EQ(compare(bx, uint64_t(y)), compare(bx, by));
+            }
+            if (y == int32_t(y)) {
+                EXPECT_EQ(compare(bx, int(y)), compare(bx, by));
+            }
+        }
+        EXPECT_EQ(compare(bx, UINT64_MAX), -1);
+        EXPECT_EQ(compare(bx + (big_integer(1) << 70), x), 1);
+        EXPECT_EQ(compare(bx - (big_integer(1) << 70), x), -1);
+    }
+    EXPECT_EQ(compare(big_integer(std::to_string(UINT64_MAX)), UINT64_MAX), 0);
+    EXPECT_EQ(compare(big_integer(std::to_string(UINT64_MAX)), INT64_MAX), 1);
+    EXPECT_EQ(compare(big_integer(7), 7u), 0);
+}
+
+namespace
+{
+template <typename T>
+void check_native(big_integer const &a, T b)
+{
+    big_integer const bb(std::to_string(b));
+    EXPECT_EQ(a + b, a + bb);
+    EXPECT_EQ(b + a, a + bb);
+    EXPECT_EQ(a - b, a - bb);
+    EXPECT_EQ(b - a, bb - a);
+    EXPECT_EQ(a * b, a * bb);
+    EXPECT_EQ(b * a, a * bb);
+    if (b != 0) {
+        EXPECT_EQ(a / b, a / bb);
+        EXPECT_EQ(a % b, a % bb);
+    }
+    if (!a.is_zero()) {
+        EXPECT_EQ(b / a, bb / a);
+        EXPECT_EQ(b % a, bb % a);
+    }
+    EXPECT_EQ(a == b, a == bb);
+    EXPECT_EQ(a < b, a < bb);
+    EXPECT_EQ(b < a, bb < a);
+    EXPECT_EQ(b >= a, bb >= a);
+
+    big_integer c = a;
+    c += b;
+    c *= b;
+    c -= b;
+    EXPECT_EQ(c, (a + bb) * bb - bb);
+    if (b != 0) {
+        c /= b;
+        EXPECT_EQ(c, ((a + bb) * bb - bb) / bb);
+        c = a;
+        c %= b;
+        EXPECT_EQ(c, a % bb);
+    }
+}
+} // namespace
+
+TEST(correctness, native_operands_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 10; ++itn) {
+        big_integer a = rand_signed_big(rand() % 4);
+        if (itn % 5 == 0) a = (itn % 2 ? 1 : -1) * (big_integer(1) << (32 * (itn % 4)));
+        if (itn % 7 == 0) a = itn % 2 ? 0 : -1;
+        check_native(a, rand() % 2000 - 1000);
+        check_native(a, int(rand()) * (rand() % 2 ? 1 : -1));
+        check_native(a, 0);
+        check_native(a, -1);
+        check_native(a, INT32_MIN);
+        check_native(a, uint32_t(rand()) << 1);
+        check_native(a, UINT32_MAX);
+        check_native(a, int64_t(rand()) << 31);
+        check_native(a, -(int64_t(rand()) << 31));
+        check_native(a, INT64_MIN);
+        check_native(a, INT64_MAX);
+        check_native(a, uint64_t(rand()) << 40);
+        check_native(a, UINT64_MAX);
+        check_native(a, size_t(rand()));
+    }
+
+    big_integer x = 7;
+    x -= 10;
+    EXPECT_EQ(x, -3);
+    x *= -4;
+    EXPECT_EQ(x, 12);
+    x = big_integer(1) << 64;
+    x -= 1;
+    EXPECT_EQ(x, big_integer(UINT64_MAX));
+    x += 1u;
+    EXPECT_EQ(x % 3, 1);
+    EXPECT_EQ(-x % 3, -1);
+}
+
+TEST(correctness, native_conversions)
+{
+    big_integer const max64(std::to_string(INT64_MAX)), min64(std::to_string(INT64_MIN));
+    big_integer const umax64(std::to_string(UINT64_MAX));
+    EXPECT_EQ(max64.to_int64(), INT64_MAX);
+    EXPECT_EQ(min64.to_int64(), INT64_MIN);
+    EXPECT_EQ(big_integer(-1).to_int64(), -1);
+    EXPECT_EQ(big_integer(0).to_uint64(), 0u);
+    EXPECT_EQ(umax64.to_uint64(), UINT64_MAX);
+    EXPECT_EQ((-(big_integer(1) << 32)).to_int64(), -(int64_t(1) << 32));
+    EXPECT_FALSE((max64 + 1).fits_int64());
+    EXPECT_FALSE((min64 - 1).fits_int64());
+    EXPECT_TRUE((max64 + 1).fits_uint64());
+    EXPECT_FALSE((umax64 + 1).fits_uint64());
+    EXPECT_FALSE(big_integer(-1).fits_uint64());
+    EXPECT_THROW((max64 + 1).to_int64(), std::runtime_error);
+    EXPECT_THROW(big_integer(-1).to_uint64(), std::runtime_error);
+    for (size_t itn = 0; itn != 100; ++itn) {
+        big_integer a = rand_signed_big(rand() % 3);
+        big_integer b = rand_signed_big(rand() % 6);
+        EXPECT_EQ(a.fits_int64(), a >= min64 && a <= max64);
+        if (a.fits_int64()) {
+            EXPECT_EQ(to_string(a), std::to_string(a.to_int64()));
+        }
+        EXPECT_EQ(b.fits_uint64(), b >= 0 && b <= umax64);
+        if (b.fits_uint64()) {
+            EXPECT_EQ(to_string(b), std::to_string(b.to_uint64()));
+        }
+    }
+}
+
+TEST(correctness, double_conversions)
+{
+    big_integer const p53 = big_integer(1) << 53;
+    EXPECT_EQ((p53 + 1).to_double(), 9007199254740992.0);
+    EXPECT_EQ((p53 + 3).to_double(), 9007199254740996.0);
+    EXPECT_EQ((-(p53 + 1)).to_double(), -9007199254740992.0);
+    EXPECT_EQ((((p53 + 1) << 100) + 1).to_double(), std::ldexp(9007199254740994.0, 100));
+    EXPECT_EQ((-(p53 << 100) - 1).to_double(), -std::ldexp(1.0, 153));
+    EXPECT_EQ((big_integer(1) << 1023).to_double(), std::ldexp(1.0, 1023));
+    EXPECT_EQ(((big_integer(1) << 1024) - (big_integer(1) << 970)).to_double(), HUGE_VAL);
+    EXPECT_EQ((-(big_integer(1) << 5000)).to_double(), -HUGE_VAL);
+    EXPECT_EQ(big_integer(-1).to_double(), -1.0);
+    EXPECT_EQ(big_integer(0).to_double(), 0.0);
+    for (size_t itn = 0; itn != 200; ++itn) {
+        big_integer a = rand_signed_big(rand() % 40) << (rand() % 100);
+        std::string str = to_string(a);
+        EXPECT_EQ(a.to_double(), std::strtod(str.c_str(), nullptr)) << str;
+    }
+
+    EXPECT_EQ(big_integer(0.0), 0);
+    EXPECT_EQ(big_integer(-0.75), 0);
+    EXPECT_EQ(big_integer(-1.5), -1);
+    EXPECT_EQ(big_integer(1e19), big_integer("10000000000000000000"));
+    EXPECT_EQ(big_integer(std::ldexp(-1.0, 200)), -(big_integer(1) << 200));
+    EXPECT_EQ(big_integer(std::ldexp(3.0L, 100)), big_integer(3) << 100);
+    EXPECT_THROW(big_integer(std::nan("")), std::runtime_error);
+    EXPECT_THROW(big_integer(-HUGE_VAL), std::runtime_error);
+    for (size_t itn = 0; itn != 200; ++itn) {
+        double d = std::ldexp(double(rand()) / RAND_MAX - 0.5, rand() % 1000);
+        char buf[400];
+        std::snprintf(buf, sizeof(buf), "%.0f", std::trunc(d));
+        big_integer a(d);
+        EXPECT_EQ(to_string(a), buf[0] == '-' && buf[1] == '0' ? "0" : buf);
+        EXPECT_EQ(a.to_double(), std::trunc(d));
+        long double ld = std::ldexp(static_cast<long double>(d), rand() % 100) + rand();
+        std::snprintf(buf, sizeof(buf), "%.0Lf", std::trunc(ld));
+        EXPECT_EQ(to_string(big_integer(ld)), buf[0] == '-' && buf[1] == '0' ? "0" : buf);
+    }
+}
+
+TEST(correctness, shift_in_place_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 10; ++itn) {
+        big_integer a = rand_signed_big(rand() % 60);
+        uint64_t k = rand() % 2000;
+        big_integer b = a, c = a;
+        b <<= k;
+        c >>= k;
+        EXPECT_EQ(b, a << k);
+        EXPECT_EQ(c, a >> k);
+        b >>= k;
+        EXPECT_EQ(b, a);
+        EXPECT_EQ((c << k) + (a & ((big_integer(1) << k) - 1)), a);
+    }
+
+    uint64_t const huge = uint64_t(1) << 40;
+    big_integer zero, minus_one = -1, a = rand_big(10) + 1;
+    zero <<= huge;
+    EXPECT_EQ(zero, 0);
+    EXPECT_EQ(big_integer(0) << huge, 0);
+    EXPECT_EQ(a >> huge, 0);
+    EXPECT_EQ(-a >> huge, -1);
+    minus_one >>= huge;
+    EXPECT_EQ(minus_one, -1);
+    a >>= huge;
+    EXPECT_EQ(a, 0);
+}
+
+namespace
+{
+std::vector<big_integer> kernel_results(std::vector<big_integer> const &args)
+{
+    std::vector<big_integer> res;
+    for (size_t i = 0; i + 1 < args.size(); i += 2) {
+        big_integer const &a = args[i], &b = args[i + 1];
+        res.push_back(a + b);
+        res.push_back(a - b);
+        res.push_back(a * b);
+        res.push_back((a * b + a) / b);
+        res.push_back(a & b);
+        res.push_back(a | b);
+        res.push_back(a ^ b);
+        res.push_back(a << 77);
+        res.push_back(a >> 45);
+        res.push_back(big_integer(uint64_t(a.abs().popcount())));
+        res.push_back(big_integer(uint64_t(hamming_distance(a.abs(), b.abs()))));
+        res.push_back(big_integer(uint64_t(hamming_distance(~a.abs(), ~b.abs()))));
+    }
+    return res;
+}
+} // namespace
+
+TEST(correctness, kernel_variants_agree)
+{
+    std::vector<big_integer> args;
+    for (size_t i = 0; i != 100; ++i)
+        args.push_back(rand_signed_big(rand() % 60 + 1));
+
+    ASSERT_TRUE(select_kernels("scalar"));
+    std::vector<big_integer> expected = kernel_results(args);
+
+    char const *variants[] = {"sse4.2", "avx2", "avx512"};
+    for (char const *name : variants) {
+        if (!select_kernels(name))
+            continue;
+        EXPECT_TRUE(kernel_results(args) == expected) << name;
+    }
+    EXPECT_FALSE(select_kernels("no-such-isa"));
+    EXPECT_TRUE(select_kernels("auto"));
+}
+
+TEST(correctness, mul_karatsuba_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer a = rand_signed_big(rand() % 400 + 30);
+        big_integer b = rand_signed_big(rand() % 400 + 30);
+        big_integer c = rand_signed_big(rand() % 10);
+        big_integer ab = a * b;
+        EXPECT_EQ(ab / a, b);
+        EXPECT_EQ(ab % b, 0);
+        EXPECT_EQ(a * (b + c), ab + a * c);
+    }
+}
+
+TEST(correctness, mul_parallel_matches_serial)
+{
+    big_integer a = rand_signed_big(5000);
+    big_integer b = rand_signed_big(2500);
+
+    set_thread_count(1);
+    big_integer serial = a * b;
+    set_thread_count(4);
+    big_integer parallel = a * b;
+    set_thread_count(1);
+
+    EXPECT_EQ(serial, parallel);
+    EXPECT_EQ(serial / b, a);
+}
+
+namespace
+{
+long long parallel_sum(std::vector<int> const &v, size_t lo, size_t hi)
+{
+    if (hi - lo < 64) {
+        long long s = 0;
+        for (size_t i = lo; i != hi; ++i)
+            s += v[i];
+        return s;
+    }
+    long long left = 0;
+    task_group group;
+    group.run([&]() { left = parallel_sum(v, lo, (lo + hi) / 2); });
+    long long right = parallel_sum(v, (lo + hi) / 2, hi);
+    group.wait();
+    return left + right;
+}
+} // namespace
+
+TEST(correctness, task_group_nested_fork_join)
+{
+    std::vector<int> v(100000);
+    for (size_t i = 0; i != v.size(); ++i)
+        v[i] = myrand();
+    long long expected = parallel_sum(v, 0, v.size());
+
+    set_thread_count(4);
+    EXPECT_EQ(get_thread_count(), 4u);
+    EXPECT_EQ(parallel_sum(v, 0, v.size()), expected);
+
+    task_group group;
+    group.run([]() { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(group.wait(), std::runtime_error);
+    set_thread_count(1);
+}
+
+TEST(correctness, mul_parallel_from_many_threads)
+{
+    big_integer a = rand_signed_big(3000);
+    big_integer b = rand_signed_big(2200);
+    big_integer expected = a * b;
+
+    set_thread_count(3);
+    std::vector<big_integer> results(4);
+    std::vector<std::thread> users;
+    for (size_t i = 0; i != results.size(); ++i)
+        users.emplace_back([&, i]() { results[i] = a * b; });
+    for (size_t i = 0; i != users.size(); ++i)
+        users[i].join();
+    set_thread_count(1);
+
+    for (size_t i = 0; i != results.size(); ++i)
+        EXPECT_EQ(results[i], expected);
+}
+
+TEST(correctness, task_group_many_threads_stay_in_budget)
+{
+    std::atomic<size_t> running(0);
+    std::atomic<size_t> peak(0);
+    std::atomic<size_t> ran(0);
+    auto task = [&]() {
+        size_t now = ++running;
+        size_t seen = peak;
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        --running;
+        ++ran;
+    };
+
+    set_thread_count(3);
+    std::vector<std::thread> users;
+    for (size_t i = 0; i != 6; ++i)
+        users.emplace_back([&]() {
+            for (size_t round = 0; round != 10; ++round) {
+                task_group group;
+                for (size_t j = 0; j != 8; ++j)
+                    group.run(task);
+                group.wait();
+            }
+        });
+    for (size_t i = 0; i != users.size(); ++i)
+        users[i].join();
+    set_thread_count(1);
+
+    EXPECT_EQ(ran, 6u * 10 * 8);
+    EXPECT_LE(peak, 3u);
+}
+
+TEST(correctness, div_by_zero_throws)
+{
+    big_integer a("123456789012345678901234567890");
+    big_integer zero;
+    EXPECT_THROW(a / zero, std::runtime_error);
+    EXPECT_THROW(a % zero, std::runtime_error);
+    EXPECT_THROW(a / 0, std::runtime_error);
+    EXPECT_THROW(a % 0u, std::runtime_error);
+    EXPECT_THROW(a /= 0, std::runtime_error);
+    EXPECT_EQ(a, big_integer("123456789012345678901234567890"));
+}
+
+TEST(correctness, div_by_longer)
+{
+    big_integer a = 5;
+    big_integer b("1000000000000000000000000000000");
+
+    EXPECT_EQ(a / b, 0);
+    EXPECT_EQ(a % b, 5);
+    EXPECT_EQ(-a % b, -5);
+}
+
+TEST(correctness, div_full_top_limb)
+{
+    big_integer a("-4294967295");
+
+    EXPECT_EQ(a / 1, a);
+    EXPECT_EQ(a / -1, -a);
+    EXPECT_EQ(to_string(a / 1), "-4294967295");
+}
+
+TEST(correctness, div_long_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 5; ++itn) {
+        big_integer divident = rand_signed_big(rand() % 700 + 1);
+        big_integer divisor = rand_signed_big(rand() % 300 + 1);
+        big_integer quotient = divident / divisor;
+        big_integer residue = divident % divisor;
+        ASSERT_EQ(quotient * divisor + residue, divident);
+        EXPECT_LT(residue.abs(), divisor.abs());
+        EXPECT_TRUE(residue == 0 || residue.is_negative() == divident.is_negative());
+    }
+}
+
+TEST(correctness, string_conv_long_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 5; ++itn) {
+        std::string s(1, static_cast<char>('1' + rand() % 9));
+        size_t len = rand() % 5000;
+        for (size_t i = 0; i != len; ++i)
+            s.push_back(static_cast<char>('0' + rand() % 10));
+        if (rand() % 2)
+            s = "-" + s;
+        EXPECT_EQ(to_string(big_integer(s)), s);
+    }
+    EXPECT_EQ(big_integer("000000000000000000000000000000000000123"), 123);
+    EXPECT_THROW(big_integer("12a4"), std::runtime_error);
+}
+
+TEST(correctness, string_conv_parallel)
+{
+    big_integer a = rand_signed_big(8000);
+    std::string serial = to_string(a);
+
+    set_thread_count(4);
+    std::string parallel = to_string(a);
+    big_integer back(parallel);
+    set_thread_count(1);
+
+    EXPECT_EQ(parallel, serial);
+    EXPECT_EQ(back, a);
+}
+
+namespace
+{
+big_integer naive_powmod(big_integer base, big_integer exp, big_integer const& mod)
+{
+    big_integer result = 1 % mod;
+    base %= mod;
+    while (exp > 0) {
+        if ((exp & 1) == 1)
+            result = result * base % mod;
+        base = base * base % mod;
+        exp >>= 1;
+    }
+    return result < 0 ? result + mod : result;
+}
+} // namespace
+
+TEST(correctness, powmod_small)
+{
+    EXPECT_EQ(powmod(3, 200, 1000), 1);
+    EXPECT_EQ(powmod(2, 10, 1000), 24);
+    EXPECT_EQ(powmod(-2, 3, 7), 6);
+    EXPECT_EQ(powmod(5, 0, 7), 1);
+    EXPECT_EQ(powmod(5, 0, 1), 0);
+    EXPECT_EQ(powmod(0, 5, 12), 0);
+    EXPECT_EQ(powmod(7, 123, 4294967296u), naive_powmod(7, 123, 4294967296u));
+
+    big_integer p("170141183460469231731687303715884105727");
+    EXPECT_EQ(powmod(123456789, p - 1, p), 1);
+
+    EXPECT_THROW(powmod(2, 3, 0), std::runtime_error);
+    EXPECT_THROW(powmod(2, -3, 7), std::runtime_error);
+    EXPECT_THROW(montgomery_context(big_integer(10)), std::runtime_error);
+}
+
+TEST(correctness, powmod_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer mod = rand_big(rand() % 60 + 1) + 2;
+        big_integer base = rand_signed_big(rand() % 80);
+        big_integer exp = rand_big(rand() % 20);
+        EXPECT_EQ(powmod(base, exp, mod), naive_powmod(base, exp, mod));
+    }
+}
+
+TEST(correctness, montgomery_context_reuse)
+{
+    big_integer mod = (rand_big(70) << 1) + 1;
+    montgomery_context ctx(mod);
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer a = rand_signed_big(rand() % 90);
+        big_integer b = rand_signed_big(rand() % 90);
+        big_integer expected = a * b % mod;
+        EXPECT_EQ(ctx.mul(a, b), expected < 0 ? expected + mod : expected);
+    }
+    EXPECT_EQ(ctx.pow(3, 1000), naive_powmod(3, 1000, mod));
+}
+
+TEST(correctness, barrett_reducer_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer mod = rand_big(rand() % 40) + 1;
+        barrett_reducer reducer(mod);
+        for (size_t i = 0; i != 10; ++i) {
+            big_integer a = rand_signed_big(rand() % 100);
+            big_integer b = rand_signed_big(rand() % 50);
+            big_integer expected = a % mod;
+            EXPECT_EQ(reducer.reduce(a), expected < 0 ? expected + mod : expected);
+            expected = a * b % mod;
+            EXPECT_EQ(reducer.mulmod(a, b), expected < 0 ? expected + mod : expected);
+            EXPECT_EQ(reducer.sqrmod(b), b * b % mod);
+        }
+        EXPECT_EQ(reducer.reduce(mod), 0);
+        EXPECT_EQ(reducer.reduce(-mod), 0);
+        EXPECT_EQ(reducer.reduce(mod - 1), mod - 1);
+    }
+    EXPECT_THROW(barrett_reducer(big_integer(0)), std::runtime_error);
+}
+
+TEST(correctness, sqr_karatsuba_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 5; ++itn) {
+        big_integer a = rand_signed_big(rand() % 300 + 1);
+        big_integer b = a;
+        EXPECT_EQ(a * a, a * (b + 1) - a);
+    }
+}
+
+TEST(correctness, pow_small)
+{
+    EXPECT_EQ(big_integer(2).pow(100), big_integer(1) << 100);
+    EXPECT_EQ(big_integer(-3).pow(5), -243);
+    EXPECT_EQ(big_integer(-1).pow(1000001), -1);
+    EXPECT_EQ(big_integer(0).pow(0), 1);
+    EXPECT_EQ(big_integer(0).pow(7), 0);
+    EXPECT_EQ(big_integer(7).pow(1), 7);
+    EXPECT_EQ(big_integer(-4096).pow(3), -(big_integer(1) << 36));
+    EXPECT_EQ(to_string(big_integer(10).pow(30)), "1" + std::string(30, '0'));
+    EXPECT_EQ(to_string(big_integer(12).pow(20)), "3833759992447475122176");
+}
+
+TEST(correctness, pow_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 5; ++itn) {
+        big_integer base = rand_signed_big(rand() % 5) << (rand() % 70);
+        uint64_t n = rand() % 40;
+        big_integer expected = 1;
+        for (uint64_t i = 0; i != n; ++i)
+            expected *= base;
+        EXPECT_EQ(base.pow(n), expected);
+    }
+    big_integer three = big_integer(3).pow(5000);
+    EXPECT_EQ(three.pow(3), big_integer(3).pow(15000));
+}
+
+namespace
+{
+big_integer euclid_gcd(big_integer a, big_integer b)
+{
+    a = a.abs();
+    b = b.abs();
+    while (!b.is_zero()) {
+        big_integer r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+} // namespace
+
+TEST(correctness, gcd_small)
+{
+    EXPECT_EQ(gcd(0, 0), 0);
+    EXPECT_EQ(gcd(0, -5), 5);
+    EXPECT_EQ(gcd(12, 18), 6);
+    EXPECT_EQ(gcd(-12, 18), 6);
+    EXPECT_EQ(gcd(17, 5), 1);
+    EXPECT_EQ(gcd(big_integer(1) << 100, big_integer(3) << 40), big_integer(1) << 40);
+    big_integer f = big_integer(1);
+    big_integer g = big_integer(1);
+    for (int i = 0; i != 500; ++i) {
+        big_integer t = f + g;
+        f = g;
+        g = t;
+    }
+    EXPECT_EQ(gcd(f, g), 1);
+}
+
+TEST(correctness, gcd_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 5; ++itn) {
+        big_integer c = rand_big(rand() % 30);
+        big_integer a = rand_signed_big(rand() % 80) * c;
+        big_integer b = rand_signed_big(rand() % 80) * c;
+        EXPECT_EQ(gcd(a, b), euclid_gcd(a, b));
+    }
+}
+
+TEST(correctness, gcd_half_gcd)
+{
+    for (size_t itn = 0; itn != 4; ++itn) {
+        big_integer c = rand_big(rand() % 400);
+        big_integer a = rand_big(2000 + rand() % 1000) * c;
+        big_integer b = rand_big(2000 + rand() % 1000) * c;
+        big_integer g = gcd(a, b);
+        EXPECT_EQ(a % g, 0);
+        EXPECT_EQ(b % g, 0);
+        EXPECT_EQ(gcd(a / g, b / g), 1);
+        EXPECT_EQ(g, euclid_gcd(a, b));
+    }
+}
+
+TEST(correctness, xgcd_small)
+{
+    xgcd_result r = xgcd(240, 46);
+    EXPECT_EQ(r.g, 2);
+    EXPECT_EQ(r.s, 14);
+    EXPECT_EQ(r.t, -73);
+    r = xgcd(-5, 0);
+    EXPECT_EQ(r.g, 5);
+    EXPECT_EQ(r.s, -1);
+    EXPECT_EQ(r.t, 0);
+    // the cofactor of a zero a is not recovered by a division by it
+    testing::internal::CaptureStdout();
+    r = xgcd(0, -7);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    EXPECT_EQ(r.g, 7);
+    EXPECT_EQ(r.s, 0);
+    EXPECT_EQ(r.t, -1);
+    r = xgcd(0, 0);
+    EXPECT_EQ(r.g, 0);
+}
+
+TEST(correctness, xgcd_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 5 + 2; ++itn) {
+        big_integer c = rand_big(rand() % 30);
+        size_t len = (itn < 2) ? 2000 + rand() % 1000 : rand() % 80;
+        big_integer a = rand_signed_big(rand() % 80 + len) * c;
+        big_integer b = rand_signed_big(len) * c;
+        if (b.is_zero()) continue;
+        xgcd_result r = xgcd(a, b);
+        EXPECT_EQ(r.g, euclid_gcd(a, b));
+        EXPECT_EQ(r.s * a + r.t * b, r.g);
+        EXPECT_TRUE(r.s >= 0 && r.s < b.abs() / r.g);
+    }
+}
+
+TEST(correctness, modinv)
+{
+    EXPECT_EQ(modinv(3, 7), 5);
+    EXPECT_EQ(modinv(-3, 7), 2);
+    EXPECT_EQ(modinv(5, 1), 0);
+    EXPECT_THROW(modinv(6, 9), std::runtime_error);
+    EXPECT_THROW(modinv(2, 0), std::runtime_error);
+
+    big_integer p = (big_integer(1) << 521) - 1;
+    std::vector<big_integer> values;
+    for (size_t i = 0; i != 50; ++i) values.push_back(rand_signed_big(rand() % 40 + 1));
+    std::vector<big_integer> inverses = batch_modinv(values, p);
+    ASSERT_EQ(inverses.size(), values.size());
+    for (size_t i = 0; i != values.size(); ++i) {
+        EXPECT_EQ(inverses[i], modinv(values[i], p));
+        EXPECT_EQ((values[i] * inverses[i] % p + p) % p, 1);
+    }
+    values.push_back(p * 3);
+    EXPECT_THROW(batch_modinv(values, p), std::runtime_error);
+}
+
+namespace
+{
+// (a / n) by the textbook loop: pull out twos, then reciprocity
+int naive_jacobi(big_integer a, big_integer n)
+{
+    int res = 1;
+    a %= n;
+    if (a.is_negative()) a += n;
+    while (!a.is_zero()) {
+        while ((a & 1) == 0) {
+            a >>= 1;
+            big_integer r = n % 8;
+            if (r == 3 || r == 5) res = -res;
+        }
+        if (a % 4 == 3 && n % 4 == 3) res = -res;
+        big_integer r = n % a;
+        n = a;
+        a = r;
+    }
+    return (n == 1) ? res : 0;
+}
+} // namespace
+
+TEST(correctness, jacobi_small)
+{
+    EXPECT_EQ(jacobi(2, 7), 1);
+    EXPECT_EQ(jacobi(3, 7), -1);
+    EXPECT_EQ(jacobi(-1, 7), -1);
+    EXPECT_EQ(jacobi(6, 9), 0);
+    EXPECT_EQ(jacobi(5, 1), 1);
+    EXPECT_THROW(jacobi(3, 8), std::runtime_error);
+    EXPECT_THROW(jacobi(3, -7), std::runtime_error);
+    EXPECT_EQ(kronecker(3, 0), 0);
+    EXPECT_EQ(kronecker(-1, 0), 1);
+    EXPECT_EQ(kronecker(5, 2), -1);
+    EXPECT_EQ(kronecker(7, 2), 1);
+    EXPECT_EQ(kronecker(4, 6), 0);
+    EXPECT_EQ(kronecker(-3, -7), -1);
+    EXPECT_EQ(kronecker(3, 28), jacobi(3, 7));
+
+    for (int n = 1; n < 60; n += 2) {
+        for (int a = -60; a <= 60; a++) EXPECT_EQ(jacobi(a, n), naive_jacobi(a, n));
+    }
+}
+
+TEST(correctness, jacobi_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 5; ++itn) {
+        big_integer c = rand_big(rand() % 10) * 2 + 1;
+        big_integer n = (rand_big(rand() % 100) * 2 + 1) * c;
+        big_integer a = rand_signed_big(rand() % 100) * ((itn % 3 == 0) ? c : 1);
+        EXPECT_EQ(jacobi(a, n), naive_jacobi(a, n));
+    }
+}
+
+TEST(correctness, jacobi_large)
+{
+    // (a / m n) = (a / m) (a / n) with m n past JACOBI_DC_THRESHOLD limbs; a negative a a
+    // little shorter than m n leaves a residue with the same leading bits as m n
+    size_t len = JACOBI_DC_THRESHOLD * 32 / 31 / 2 + 100;
+    for (size_t itn = 0; itn != 3; ++itn) {
+        big_integer m = rand_big(len) * 2 + 1, n = rand_big(len + rand() % 100) * 2 + 1;
+        big_integer a = (itn == 0) ? -rand_big(2 * len - 50) : rand_signed_big(2 * len);
+        EXPECT_EQ(jacobi(a, m * n), jacobi(a, m) * jacobi(a, n));
+        EXPECT_EQ(jacobi(a * a, m * n), (gcd(a, m * n) == 1) ? 1 : 0);
+    }
+}
+
+TEST(correctness, sqrtrem_small)
+{
+    for (uint32_t i = 0; i != 2000; ++i) {
+        sqrtrem_result r = sqrtrem(i);
+        EXPECT_TRUE(r.s * r.s <= i && (r.s + 1) * (r.s + 1) > i);
+        EXPECT_EQ(r.r, i - r.s * r.s);
+    }
+    big_integer big = (big_integer(1) << 200) - 1;
+    EXPECT_EQ(isqrt(big * big), big);
+    EXPECT_EQ(isqrt(big * big - 1), big - 1);
+    EXPECT_THROW(sqrtrem(-1), std::runtime_error);
+}
+
+TEST(correctness, sqrtrem_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 5; ++itn) {
+        big_integer a = rand_big(rand() % (itn < 5 ? 1000 : 60) + 1);
+        sqrtrem_result r = sqrtrem(a);
+        EXPECT_EQ(r.s * r.s + r.r, a);
+        EXPECT_TRUE(!r.r.is_negative() && r.r <= 2 * r.s);
+    }
+}
+
+TEST(correctness, iroot)
+{
+    EXPECT_EQ(iroot(0, 3), 0);
+    EXPECT_EQ(iroot(26, 3), 2);
+    EXPECT_EQ(iroot(27, 3), 3);
+    EXPECT_EQ(iroot(-27, 3), -3);
+    EXPECT_EQ(iroot(big_integer(1) << 100, 100), 2);
+    EXPECT_EQ(iroot((big_integer(1) << 100) - 1, 100), 1);
+    EXPECT_THROW(iroot(-4, 2), std::runtime_error);
+    EXPECT_THROW(iroot(4, 0), std::runtime_error);
+    for (size_t itn = 0; itn != number_of_iterations * 2; ++itn) {
+        unsigned k = rand() % 20 + 2;
+        big_integer a = rand_big(rand() % 100 + 1);
+        big_integer x = iroot(a, k);
+        EXPECT_TRUE(x.pow(k) <= a && (x + 1).pow(k) > a);
+        EXPECT_EQ(iroot(x.pow(k), k), x);
+    }
+}
+
+TEST(correctness, is_perfect_square)
+{
+    for (int i = 0; i != 1000; ++i) {
+        int s = 0;
+        while ((s + 1) * (s + 1) <= i) ++s;
+        EXPECT_EQ(is_perfect_square(i), s * s == i);
+    }
+    EXPECT_FALSE(is_perfect_square(-4));
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer a = rand_big(rand() % 100 + 1);
+        EXPECT_TRUE(is_perfect_square(a * a));
+        EXPECT_FALSE(is_perfect_square(a * a + 2 * a + 2));
+    }
+}
+
+TEST(correctness, bit_length)
+{
+    EXPECT_EQ(big_integer(0).bit_length(), 0u);
+    EXPECT_EQ(big_integer(1).bit_length(), 1u);
+    EXPECT_EQ(big_integer(-1).bit_length(), 1u);
+    EXPECT_EQ(big_integer(-2).bit_length(), 2u);
+    EXPECT_EQ(big_integer(-3).bit_length(), 2u);
+    EXPECT_EQ(big_integer(255).bit_length(), 8u);
+    EXPECT_EQ(big_integer(-256).bit_length(), 9u);
+    EXPECT_EQ(big_integer(-257).bit_length(), 9u);
+    for (uint32_t k = 30; k != 100; ++k) {
+        big_integer p = big_integer(1) << k;
+        EXPECT_EQ(p.bit_length(), k + 1);
+        EXPECT_EQ((-p).bit_length(), k + 1);
+        EXPECT_EQ((p - 1).bit_length(), k);
+        EXPECT_EQ((1 - p).bit_length(), k);
+        EXPECT_EQ((-p - 1).bit_length(), k + 1);
+        EXPECT_EQ(p.ilog2(), k);
+        EXPECT_EQ((p + 1).ilog2(), k);
+    }
+    EXPECT_THROW(big_integer(0).ilog2(), std::runtime_error);
+    EXPECT_THROW(big_integer(-5).ilog2(), std::runtime_error);
+}
+
+TEST(correctness, bits_small)
+{
+    big_integer a;
+    a.set_bit(100);
+    EXPECT_EQ(a, big_integer(1) << 100);
+    a.flip_bit(0);
+    a.clear_bit(100);
+    EXPECT_EQ(a, 1);
+    a.clear_bit(0);
+    EXPECT_TRUE(a.is_zero());
+
+    big_integer b(-1);
+    EXPECT_TRUE(b.test_bit(1000));
+    b.clear_bit(70);
+    EXPECT_EQ(b, -1 - (big_integer(1) << 70));
+    b.set_bit(70);
+    EXPECT_EQ(b, -1);
+    b.flip_bit(5);
+    EXPECT_EQ(b, -33);
+
+    EXPECT_EQ(big_integer(0).popcount(), 0u);
+    EXPECT_EQ(((big_integer(1) << 200) - 1).popcount(), 200u);
+    EXPECT_EQ(big_integer(-1).popcount(), SIZE_MAX);
+    EXPECT_EQ(big_integer(0).count_trailing_zeros(), SIZE_MAX);
+    EXPECT_EQ(big_integer(-1).count_trailing_zeros(), 0u);
+    EXPECT_EQ((-(big_integer(1) << 64)).count_trailing_zeros(), 64u);
+    EXPECT_EQ(big_integer(12).scan1(4), SIZE_MAX);
+    EXPECT_EQ(big_integer(-16).scan0(0), 0u);
+    EXPECT_EQ(big_integer(-16).scan0(4), SIZE_MAX);
+    EXPECT_EQ((-(big_integer(1) << 64)).scan1(100), 100u);
+    EXPECT_EQ((big_integer(1) << 64).scan0(64), 65u);
+}
+
+TEST(correctness, bits_randomized)
+{
+    for (size_t iter = 0; iter != 200; ++iter) {
+        big_integer a = rand_signed_big(rand() % 4) << (rand() % 70);
+        uint32_t k = rand() % 200;
+        big_integer bit = big_integer(1) << k;
+        EXPECT_EQ(a.test_bit(k), !((a >> k) & 1).is_zero());
+
+        big_integer b = a;
+        b.set_bit(k);
+        EXPECT_EQ(b, a | bit);
+        b = a;
+        b.clear_bit(k);
+        EXPECT_EQ(b, a & ~bit);
+        b = a;
+        b.flip_bit(k);
+        EXPECT_EQ(b, a ^ bit);
+
+        size_t ones = 0, one = SIZE_MAX, zero = SIZE_MAX;
+        for (size_t i = 0; i != 400; ++i) {
+            bool set = !((a >> i) & 1).is_zero();
+            ones += set;
+            if (i >= k && set && one == SIZE_MAX) one = i;
+            if (i >= k && !set && zero == SIZE_MAX) zero = i;
+        }
+        EXPECT_EQ(a.popcount(), a.is_negative() ? SIZE_MAX : ones);
+        EXPECT_EQ(a.scan1(k), one);
+        EXPECT_EQ(a.scan0(k), zero);
+        EXPECT_EQ(a.count_trailing_zeros(), a.scan1(0));
+    }
+}
+
+TEST(correctness, hamming_distance)
+{
+    EXPECT_EQ(hamming_distance(0, 0), 0u);
+    EXPECT_EQ(hamming_distance(0, -1), SIZE_MAX);
+    EXPECT_EQ(hamming_distance(-1, -(big_integer(1) << 100)), 100u);
+    EXPECT_EQ(hamming_distance(big_integer(1) << 300, 1), 2u);
+    for (size_t iter = 0; iter != 200; ++iter) {
+        big_integer a = rand_signed_big(rand() % 50), b = rand_signed_big(rand() % 50);
+        if (a.is_negative() != b.is_negative())
+            EXPECT_EQ(hamming_distance(a, b), SIZE_MAX);
+        else
+            EXPECT_EQ(hamming_distance(a, b), (a ^ b).popcount());
+        EXPECT_EQ(hamming_distance(a, a), 0u);
+        EXPECT_EQ(hamming_distance(a, ~a), SIZE_MAX);
+    }
+}
+
+TEST(correctness, ilog)
+{
+    EXPECT_EQ(ilog(1, 10), 0u);
+    EXPECT_EQ(ilog(999, 10), 2u);
+    EXPECT_EQ(ilog(1000, 10), 3u);
+    EXPECT_EQ(ilog(big_integer(1) << 100, 8), 33u);
+    EXPECT_THROW(ilog(0, 10), std::runtime_error);
+    EXPECT_THROW(ilog(10, 1), std::runtime_error);
+    big_integer p = big_integer(3).pow(1000);
+    EXPECT_EQ(ilog(p, 3), 1000u);
+    EXPECT_EQ(ilog(p - 1, 3), 999u);
+    EXPECT_EQ(ilog(p, 9), 500u);
+    EXPECT_EQ(ilog(p, p + 1), 0u);
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer a = rand_big(rand() % 200 + 1), base = rand_big(rand() % 3) + 2;
+        size_t e = ilog(a, base);
+        EXPECT_TRUE(base.pow(e) <= a && a < base.pow(e + 1));
+    }
+}
+
+TEST(correctness, is_perfect_power)
+{
+    std::vector<bool> power(2001);
+    power[0] = power[1] = true;
+    for (int b = 2; b * b <= 2000; ++b)
+        for (int p = b * b; p <= 2000; p *= b)
+            power[p] = true;
+    for (int i = 0; i <= 2000; ++i) EXPECT_EQ(is_perfect_power(i), power[i]);
+    EXPECT_TRUE(is_perfect_power(-1));
+    EXPECT_TRUE(is_perfect_power(-8));
+    EXPECT_TRUE(is_perfect_power(-64));
+    EXPECT_FALSE(is_perfect_power(-4));
+    EXPECT_FALSE(is_perfect_power(-2));
+    EXPECT_TRUE(is_perfect_power(big_integer(1) << 1031));
+    EXPECT_FALSE(is_perfect_power((big_integer(1) << 1031) * 3));
+    EXPECT_TRUE(is_perfect_power(-(big_integer(1) << 1035)));
+    EXPECT_FALSE(is_perfect_power(-(big_integer(1) << 1024)));
+    EXPECT_TRUE(is_perfect_power(big_integer(1031).pow(37)));
+    EXPECT_FALSE(is_perfect_power(big_integer(1031).pow(37) * 1033));
+
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer b = rand_big(rand() % 20 + 1) + 2;
+        unsigned k = rand() % 20 + 2;
+        big_integer a = b.pow(k);
+        EXPECT_TRUE(is_perfect_power(a));
+        EXPECT_TRUE(is_perfect_power(-a) || k % 2 == 0);
+        EXPECT_FALSE(is_perfect_power(a + 1));
+        EXPECT_FALSE(is_perfect_power(a * 1031));
+    }
+}
+
+TEST(correctness, is_probable_prime_small)
+{
+    uint32_t const lo = 1040000, hi = 1060000;
+    std::vector<bool> composite(hi);
+    for (uint32_t p = 2; p * p < hi; ++p)
+        for (uint32_t q = p * p; q < hi; q += p)
+            composite[q] = true;
+    for (uint32_t i = 0; i != 3000; ++i)
+        EXPECT_EQ(is_probable_prime(i), i >= 2 && !composite[i]);
+    for (uint32_t i = lo; i != hi; ++i)
+        EXPECT_EQ(is_probable_prime(i), !composite[i]);
+    EXPECT_FALSE(is_probable_prime(-7));
+}
+
+TEST(correctness, is_probable_prime_large)
+{
+    big_integer one = 1;
+    EXPECT_TRUE(is_probable_prime((one << 521) - 1));
+    EXPECT_TRUE(is_probable_prime((one << 607) - 1, 5));
+    EXPECT_FALSE(is_probable_prime((one << 523) - 1));
+    EXPECT_FALSE(is_probable_prime(((one << 61) - 1) * ((one << 89) - 1)));
+    // strong pseudoprimes to base 2 without factors below SMALL_PRIME_BOUND
+    EXPECT_FALSE(is_probable_prime(25326001));
+    EXPECT_FALSE(is_probable_prime(big_integer("3825123056546413051")));
+    EXPECT_FALSE(is_probable_prime(big_integer("318665857834031151167461")));
+    // a square, for which Selfridge's search never ends
+    EXPECT_FALSE(is_probable_prime(big_integer(1000003) * 1000003));
+}
+
+TEST(correctness, next_prime)
+{
+    EXPECT_EQ(next_prime(-10), 2);
+    EXPECT_EQ(next_prime(2), 3);
+    EXPECT_EQ(next_prime(13), 17);
+    EXPECT_EQ(next_prime(1020), 1021);
+    EXPECT_EQ(next_prime(big_integer(1) << 64), (big_integer(1) << 64) + 13);
+    EXPECT_EQ(next_prime((big_integer(1) << 521) - 2), (big_integer(1) << 521) - 1);
+}
+
+TEST(correctness, prime_sieve)
+{
+    big_integer const ranges[][2] = {
+        {0, 3000},
+        {1000000, 1140000},
+        {big_integer(1) << 200, (big_integer(1) << 200) + 3000},
+        {17, 17},
+    };
+    for (size_t i = 0; i != 4; ++i) {
+        prime_sieve sieve(ranges[i][0], ranges[i][1]);
+        big_integer p, expected = ranges[i][0] - 1;
+        while (sieve.next(p)) {
+            do
+                expected += 1;
+            while (!is_probable_prime(expected));
+            EXPECT_EQ(p, expected);
+        }
+        do
+            expected += 1;
+        while (!is_probable_prime(expected));
+        EXPECT_TRUE(expected >= ranges[i][1]);
+    }
+}
+
+TEST(correctness, factorial_family)
+{
+    big_integer f = 1, df_odd = 1, df_even = 1, pr = 1;
+    for (uint32_t n = 0; n != 400; ++n) {
+        if (n > 0)
+            f *= n;
+        if (n % 2 == 1 && n > 1)
+            df_odd *= n;
+        if (n % 2 == 0 && n > 0)
+            df_even *= n;
+        if (n > 1 && is_probable_prime(n))
+            pr *= n;
+        EXPECT_EQ(factorial(n), f);
+        EXPECT_EQ(double_factorial(n), n % 2 ? df_odd : df_even);
+        EXPECT_EQ(primorial(n), pr);
+    }
+    EXPECT_EQ(factorial(25), big_integer("15511210043330985984000000"));
+    EXPECT_THROW(factorial(uint64_t(1) << 40), std::runtime_error);
+}
+
+TEST(correctness, binomial)
+{
+    std::vector<big_integer> row(1, 1);
+    for (uint32_t n = 1; n != 150; ++n) {
+        std::vector<big_integer> next(n + 1, 1);
+        for (uint32_t k = 1; k < n; ++k)
+            next[k] = row[k - 1] + row[k];
+        row.swap(next);
+        for (uint32_t k = 0; k <= n; ++k)
+            EXPECT_EQ(binomial(n, k), row[k]);
+        EXPECT_EQ(binomial(n, n + 1), 0);
+    }
+    uint64_t n = uint64_t(1) << 40;
+    EXPECT_EQ(binomial(n, 2), big_integer(n) * big_integer(n - 1) / 2);
+    EXPECT_EQ(binomial(n, n - 3), big_integer(n) * big_integer(n - 1) * big_integer(n - 2) / 6);
+}
+
+TEST(correctness, fibonacci_lucas)
+{
+    big_integer f0 = 0, f1 = 1, l0 = 2, l1 = 1;
+    for (uint64_t n = 0; n != 300; ++n) {
+        EXPECT_EQ(fibonacci(n), f0);
+        EXPECT_EQ(lucas(n), l0);
+        big_integer t = f0 + f1;
+        f0 = f1;
+        f1 = t;
+        t = l0 + l1;
+        l0 = l1;
+        l1 = t;
+    }
+    // F_2n = F_n L_n
+    EXPECT_EQ(fibonacci(20000), fibonacci(10000) * lucas(10000));
+}
+
+TEST(correctness, lucas_sequence)
+{
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+        big_integer P = rand_signed_big(1), Q = rand_signed_big(1);
+        big_integer m = rand_big(rand() % 5 + 1);
+        if (m.is_zero())
+            continue;
+        if (itn % 2)
+            m += m % 2 == 0 ? 1 : 0;
+        uint32_t k = rand() % 200;
+        big_integer u0 = 0, u1 = 1, v0 = 2, v1 = P;
+        for (uint32_t i = 0; i != k; ++i) {
+            big_integer t = P * u1 - Q * u0;
+            u0 = u1;
+            u1 = t;
+            t = P * v1 - Q * v0;
+            v0 = v1;
+            v1 = t;
+        }
+        lucas_sequence_result r = lucas_sequence(P, Q, k, m);
+        EXPECT_EQ(r.u, (u0 % m + m) % m);
+        EXPECT_EQ(r.v, (v0 % m + m) % m);
+    }
+    lucas_sequence_result r = lucas_sequence(1, -1, 90, big_integer(1) << 64);
+    EXPECT_EQ(r.u, fibonacci(90));
+    EXPECT_EQ(r.v, lucas(90));
+    EXPECT_THROW(lucas_sequence(1, -1, 5, 0), std::runtime_error);
+}
+
+TEST(correctness, product_tree)
+{
+    EXPECT_EQ(product_tree(std::vector<big_integer>()).product(), 1);
+    for (size_t n = 1; n != 40; ++n) {
+        std::vector<big_integer> values;
+        big_integer expected = 1;
+        for (size_t i = 0; i != n; ++i) {
+            values.push_back(rand_signed_big(rand() % 6 + 1));
+            expected *= values.back();
+        }
+        product_tree tree(values);
+        EXPECT_EQ(tree.product(), expected);
+        EXPECT_EQ(tree.level(0).size(), n);
+        EXPECT_EQ(tree.level(tree.height() - 1).size(), 1u);
+    }
+}
+
+TEST(correctness, remainder_tree)
+{
+    for (size_t itn = 0; itn != 20; ++itn) {
+        std::vector<big_integer> moduli;
+        size_t n = rand() % 50 + 1;
+        for (size_t i = 0; i != n; ++i) {
+            big_integer m = rand_signed_big(rand() % 4 + 1);
+            moduli.push_back(m.is_zero() ? big_integer(7) : m);
+        }
+        big_integer x = rand_signed_big(rand() % 300 + 1);
+        std::vector<big_integer> rem = remainder_tree(x, moduli);
+        ASSERT_EQ(rem.size(), n);
+        for (size_t i = 0; i != n; ++i)
+            EXPECT_EQ(rem[i], x % moduli[i]);
+    }
+}
+
+TEST(correctness, remainder_tree_parallel)
+{
+    std::vector<big_integer> moduli;
+    for (size_t i = 0; i != 3000; ++i)
+        moduli.push_back(rand_big(2) + 1);
+    big_integer x = rand_signed_big(8000);
+
+    set_thread_count(4);
+    product_tree tree(moduli);
+    std::vector<big_integer> rem = remainder_tree(x, tree);
+    set_thread_count(1);
+
+    EXPECT_EQ(tree.product(), product_tree(moduli).product());
+    for (size_t i = 0; i != moduli.size(); ++i)
+        EXPECT_EQ(rem[i], x % moduli[i]);
+}
+
+TEST(correctness, crt_context)
+{
+    std::vector<big_integer> primes;
+    big_integer p = (big_integer(1) << 31) - 200;
+    for (size_t i = 0; i != 300; ++i)
+        primes.push_back(p = next_prime(p));
+    crt_context crt(primes);
+    for (size_t itn = 0; itn != 5; ++itn) {
+        big_integer x = rand_big(rand() % 200 + 1);
+        if (itn == 0)
+            x = 0;
+        EXPECT_EQ(crt.reconstruct(remainder_tree(x, primes)), x % crt.modulus());
+        EXPECT_EQ(crt.reconstruct(remainder_tree(-x, primes)), (crt.modulus() - x % crt.modulus()) % crt.modulus());
+    }
+
+    std::vector<big_integer> moduli;
+    moduli.push_back(1);
+    moduli.push_back(9);
+    moduli.push_back(4);
+    moduli.push_back(35);
+    std::vector<big_integer> residues;
+    residues.push_back(0);
+    residues.push_back(-1);
+    residues.push_back(3);
+    residues.push_back(107);
+    crt_context small(moduli);
+    EXPECT_EQ(small.modulus(), 1260);
+    EXPECT_EQ(small.reconstruct(residues), 107);
+
+    moduli.push_back(15);
+    EXPECT_THROW(crt_context bad(moduli), std::runtime_error);
+}
@@ -0,0 +1,473 @@
+#include "limb_arith.h"
+#include "limb_kernels.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+int limbs_cmp(uint32_t const* a, uint32_t const* b, size_t n) {
+    for (size_t i = n; i > 0; i--) {
+        if (a[i - 1] != b[i - 1]) return a[i - 1] < b[i - 1] ? -1 : 1;
+    }
+    return 0;
+}
+
+// r[0, rn) += a[0, an), an <= rn. Returns the carry out of r.
+static uint32_t add_into(uint32_t* r, size_t rn, uint32_t const* a, size_t an) {
+    uint32_t carry = limbs_add(r, r, a, an);
+    for (size_t i = an; carry && i < rn; i++) carry = (++r[i] == 0);
+    return carry;
+}
+
+// r[0, rn) -= a[0, an), an <= rn. Returns the borrow out of r.
+static uint32_t sub_from(uint32_t* r, size_t rn, uint32_t const* a, size_t an) {
+    uint32_t borrow = limbs_sub(r, r, a, an);
+    for (size_t i = an; borrow && i < rn; i++) borrow = (r[i]-- == 0);
+    return borrow;
+}
+
+// d[0, n) = |a[0, n) - b[0, bn)|, bn <= n. Returns true if a < b.
+static bool abs_diff(uint32_t* d, uint32_t const* a, size_t n, uint32_t const* b, size_t bn) {
+    size_t top = n;
+    while (top > bn && a[top - 1] == 0) top--;
+    bool less = (top == bn) && limbs_cmp(a, b, bn) < 0;
+    if (less) {
+        limbs_sub(d, b, a, bn);
+        memset(d + bn, 0, (n - bn) * sizeof(uint32_t));
+    } else {
+        memcpy(d, a, n * sizeof(uint32_t));
+        sub_from(d, n, b, bn);
+    }
+    return less;
+}
+
+static void mul_basecase(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+    r[an] = limbs_mul_1(r, a, an, b[0]);
+    for (size_t j = 1; j < bn; j++) {
+        r[an + j] = limbs_addmul_1(r + j, a, an, b[j]);
+    }
+}
+
+static void mul_rec(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn);
+
+// a is split into bn-sized chunks whose products only overlap pairwise, so even chunks
+// and odd chunks are each written disjointly and then summed.
+static void mul_unbalanced(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+    memset(r, 0, (an + bn) * sizeof(uint32_t));
+    vector<uint32_t> odd(an + bn, 0);
+    size_t chunks = (an + bn - 1) / bn;
+    task_group group;
+    for (size_t c = 0; c < chunks; c++) {
+        size_t len = min(bn, an - c * bn);
+        uint32_t* dst = ((c & 1) ? odd.data() : r) + c * bn;
+        uint32_t const* chunk = a + c * bn;
+        if (bn < PARALLEL_MUL_THRESHOLD) mul_rec(dst, b, bn, chunk, len);
+        else group.run([=]() { mul_rec(dst, b, bn, chunk, len); });
+    }
+    group.wait();
+    add_into(r, an + bn, odd.data(), an + bn);
+}
+
+static void mul_rec(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+    if (bn < KARATSUBA_THRESHOLD) {
+        mul_basecase(r, a, an, b, bn);
+        return;
+    }
+    size_t k = (an + 1) / 2;
+    if (bn <= k) {
+        mul_unbalanced(r, a, an, b, bn);
+        return;
+    }
+    // a = a1 * B^k + a0, b = b1 * B^k + b0;
+    // a0 * b1 + a1 * b0 = z0 + z2 + (a0 - a1) * (b1 - b0)
+    uint32_t const *a0 = a, *a1 = a + k, *b0 = b, *b1 = b + k;
+    size_t a1n = an - k, b1n = bn - k;
+    vector<uint32_t> da(k), db(k), m(2 * k);
+    bool neg = abs_diff(da.data(), a0, k, a1, a1n) == abs_diff(db.data(), b0, k, b1, b1n);
+
+    if (bn < PARALLEL_MUL_THRESHOLD) {
+        mul_rec(r, a0, k, b0, k);
+        mul_rec(r + 2 * k, a1, a1n, b1, b1n);
+        mul_rec(m.data(), da.data(), k, db.data(), k);
+    } else {
+        task_group group;
+        group.run([=]() { mul_rec(r + 2 * k, a1, a1n, b1, b1n); });
+        group.run([&]() { mul_rec(m.data(), da.data(), k, db.data(), k); });
+        mul_rec(r, a0, k, b0, k);
+        group.wait();
+    }
+
+    vector<uint32_t> mid(r, r + 2 * k);
+    mid.push_back(add_into(mid.data(), 2 * k, r + 2 * k, a1n + b1n));
+    if (neg) sub_from(mid.data(), 2 * k + 1, m.data(), 2 * k);
+    else add_into(mid.data(), 2 * k + 1, m.data(), 2 * k);
+    size_t rest = an + bn - k;
+    add_into(r + k, rest, mid.data(), min(2 * k + 1, rest));
+}
+
+void limbs_mul(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+    if (a == b && an == bn) limbs_sqr(r, a, an);
+    else mul_rec(r, a, an, b, bn);
+}
+
+// Every product a[i] * a[j], i < j, once; then doubled, plus the squares a[i]^2.
+static void sqr_basecase(uint32_t* r, uint32_t const* a, size_t n) {
+    memset(r, 0, 2 * n * sizeof(uint32_t));
+    for (size_t i = 0; i + 1 < n; i++) {
+        r[i + n] = limbs_addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    limbs_lshift(r, r, 2 * n, 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t sq = uint64_t(a[i]) * a[i];
+        uint64_t lo = r[2 * i] + (sq & 0xffffffff) + carry;
+        r[2 * i] = static_cast<uint32_t>(lo);
+        uint64_t hi = r[2 * i + 1] + (sq >> 32) + (lo >> 32);
+        r[2 * i + 1] = static_cast<uint32_t>(hi);
+        carry = hi >> 32;
+    }
+}
+
+// a = a1 * B^k + a0: 2 * a0 * a1 = a0^2 + a1^2 - (a0 - a1)^2
+static void sqr_rec(uint32_t* r, uint32_t const* a, size_t n) {
+    if (n < SQR_KARATSUBA_THRESHOLD) {
+        sqr_basecase(r, a, n);
+        return;
+    }
+    size_t k = (n + 1) / 2, a1n = n - k;
+    uint32_t const *a0 = a, *a1 = a + k;
+    vector<uint32_t> d(k), m(2 * k);
+    abs_diff(d.data(), a0, k, a1, a1n);
+
+    if (n < PARALLEL_MUL_THRESHOLD) {
+        sqr_rec(r, a0, k);
+        sqr_rec(r + 2 * k, a1, a1n);
+        sqr_rec(m.data(), d.data(), k);
+    } else {
+        task_group group;
+        group.run([=]() { sqr_rec(r + 2 * k, a1, a1n); });
+        group.run([&]() { sqr_rec(m.data(), d.data(), k); });
+        sqr_rec(r, a0, k);
+        group.wait();
+    }
+
+    vector<uint32_t> mid(r, r + 2 * k);
+    mid.push_back(add_into(mid.data(), 2 * k, r + 2 * k, 2 * a1n));
+    sub_from(mid.data(), 2 * k + 1, m.data(), 2 * k);
+    add_into(r + k, 2 * n - k, mid.data(), min(2 * k + 1, 2 * n - k));
+}
+
+void limbs_sqr(uint32_t* r, uint32_t const* a, size_t n) {
+    sqr_rec(r, a, n);
+}
+
+// Growable magnitudes for the recursive algorithms below; kept trimmed of leading zeros.
+
+typedef vector<uint32_t> limb_vector;
+
+static void trim(limb_vector& a) {
+    while (!a.empty() && a.back() == 0) a.pop_back();
+}
+
+static int cmp_vec(limb_vector const& a, limb_vector const& b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    return limbs_cmp(a.data(), b.data(), a.size());
+}
+
+static limb_vector mul_vec(uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+    limb_vector r;
+    if (an == 0 || bn == 0) return r;
+    r.resize(an + bn);
+    if (an >= bn) limbs_mul(r.data(), a, an, b, bn);
+    else limbs_mul(r.data(), b, bn, a, an);
+    trim(r);
+    return r;
+}
+
+static limb_vector mul_vec(limb_vector const& a, limb_vector const& b) {
+    return mul_vec(a.data(), a.size(), b.data(), b.size());
+}
+
+static void add_vec(limb_vector& a, limb_vector const& b) {
+    if (a.size() < b.size()) a.resize(b.size(), 0);
+    a.push_back(0);
+    add_into(a.data(), a.size(), b.data(), b.size());
+    trim(a);
+}
+
+// a -= b, a >= b
+static void sub_vec(limb_vector& a, limb_vector const& b) {
+    sub_from(a.data(), a.size(), b.data(), b.size());
+    trim(a);
+}
+
+static unsigned leading_zeros(uint32_t x) {
+    unsigned n = 0;
+    for (uint32_t bit = 0x80000000u; bit && !(x & bit); bit >>= 1) n++;
+    return n;
+}
+
+uint32_t limbs_divrem_1(uint32_t* q, uint32_t const* a, size_t n, uint32_t d) {
+    uint64_t r = 0;
+    for (size_t i = n; i-- > 0;) {
+        uint64_t cur = (r << 32) | a[i];
+        q[i] = static_cast<uint32_t>(cur / d);
+        r = cur % d;
+    }
+    return static_cast<uint32_t>(r);
+}
+
+// Knuth's algorithm D: q[0, un - n) = u / v, leaves the remainder in u[0, n).
+// v is normalized (top bit set), n >= 2, and u[un - 1] < v[n - 1].
+static void divrem_knuth(uint32_t* q, uint32_t* u, size_t un, uint32_t const* v, size_t n) {
+    uint64_t top = v[n - 1], next = v[n - 2];
+    for (size_t j = un - n; j-- > 0;) {
+        uint64_t num = (uint64_t(u[j + n]) << 32) | u[j + n - 1];
+        uint64_t qhat = num / top, rhat = num % top;
+        while (qhat > 0xffffffff || qhat * next > ((rhat << 32) | u[j + n - 2])) {
+            qhat--;
+            rhat += top;
+            if (rhat > 0xffffffff) break;
+        }
+        uint32_t borrow = limbs_submul_1(u + j, v, n, static_cast<uint32_t>(qhat));
+        bool negative = u[j + n] < borrow;
+        u[j + n] -= borrow;
+        if (negative) {
+            qhat--;
+            u[j + n] += limbs_add(u + j, u + j, v, n);
+        }
+        q[j] = static_cast<uint32_t>(qhat);
+    }
+}
+
+// floor((B^2n - 1) / d) for a normalized d of n limbs, n + 1 limbs long.
+// One Newton step doubles the precision of the reciprocal of the top half of d;
+// the few units of error left are then corrected exactly.
+static limb_vector reciprocal(uint32_t const* d, size_t n) {
+    limb_vector dv(d, d + n), one(1, 1);
+    limb_vector target(2 * n, 0xffffffff);
+    limb_vector x;
+    if (n < NEWTON_DIV_THRESHOLD) {
+        target.push_back(0);
+        x.resize(n + 1);
+        divrem_knuth(x.data(), target.data(), 2 * n + 1, d, n);
+        trim(x);
+        return x;
+    }
+    size_t h = (n + 1) / 2;
+    x = reciprocal(d + n - h, h);
+    x.insert(x.begin(), n - h, 0);
+
+    // x += x * (B^2n - d * x) / B^2n
+    limb_vector b2n(2 * n + 1, 0);
+    b2n[2 * n] = 1;
+    limb_vector e = mul_vec(dv, x);
+    bool over = cmp_vec(e, b2n) > 0;
+    if (over) {
+        sub_vec(e, b2n);
+    } else {
+        limb_vector t = b2n;
+        sub_vec(t, e);
+        e.swap(t);
+    }
+    limb_vector t = mul_vec(x, e);
+    if (t.size() > 2 * n) {
+        limb_vector step(t.begin() + 2 * n, t.end());
+        if (over) sub_vec(x, step);
+        else add_vec(x, step);
+    }
+
+    limb_vector dx = mul_vec(dv, x);
+    while (cmp_vec(dx, target) > 0) {
+        sub_vec(x, one);
+        sub_vec(dx, dv);
+    }
+    sub_vec(target, dx);
+    while (cmp_vec(target, dv) >= 0) {
+        add_vec(x, one);
+        sub_vec(target, dv);
+    }
+    return x;
+}
+
+// cur = cur % d, returns cur / d; cur < d * B^n, d normalized of n limbs, v its reciprocal.
+// The quotient is estimated from the top n + 1 limbs of cur and is off by a few units at most.
+static limb_vector divrem_block(limb_vector& cur, limb_vector const& d, limb_vector const& v) {
+    size_t n = d.size();
+    limb_vector q, one(1, 1);
+    if (cur.size() >= n) {
+        limb_vector t = mul_vec(cur.data() + n - 1, cur.size() - n + 1, v.data(), v.size());
+        if (t.size() > n + 1) q.assign(t.begin() + n + 1, t.end());
+    }
+    limb_vector prod = mul_vec(q, d);
+    while (cmp_vec(prod, cur) > 0) {
+        sub_vec(q, one);
+        sub_vec(prod, d);
+    }
+    sub_vec(cur, prod);
+    while (cmp_vec(cur, d) >= 0) {
+        add_vec(q, one);
+        sub_vec(cur, d);
+    }
+    return q;
+}
+
+limb_divisor::limb_divisor(uint32_t const* d, size_t n, bool with_inverse)
+        : shift(leading_zeros(d[n - 1])), norm(d, d + n) {
+    if (shift) limbs_lshift(norm.data(), d, n, shift);
+    if (with_inverse && n >= NEWTON_DIV_THRESHOLD) inverse = reciprocal(norm.data(), n);
+}
+
+size_t limb_divisor::size() const {
+    return norm.size();
+}
+
+void limb_divisor::divrem(uint32_t* q, uint32_t* r, uint32_t const* a, size_t an) const {
+    size_t n = norm.size(), qn = an - n + 1;
+    if (n == 1) {
+        r[0] = limbs_divrem_1(q, a, an, norm[0] >> shift);
+        return;
+    }
+    limb_vector u(an + 1);
+    if (shift) u[an] = limbs_lshift(u.data(), a, an, shift);
+    else memcpy(u.data(), a, an * sizeof(uint32_t));
+
+    if (inverse.empty() || qn < NEWTON_DIV_THRESHOLD) {
+        divrem_knuth(q, u.data(), an + 1, norm.data(), n);
+    } else {
+        // schoolbook over blocks of n limbs, each divided with the reciprocal
+        limb_vector rem;
+        size_t blocks = (an + n) / n;
+        for (size_t i = blocks; i-- > 0;) {
+            size_t lo = i * n, len = min(n, an + 1 - lo);
+            limb_vector cur(u.begin() + lo, u.begin() + lo + len);
+            cur.insert(cur.end(), rem.begin(), rem.end());
+            trim(cur);
+            limb_vector qb = divrem_block(cur, norm, inverse);
+            for (size_t j = 0; j < qb.size(); j++) {
+                if (lo + j < qn) q[lo + j] = qb[j];
+            }
+            for (size_t j = qb.size(); j < len && lo + j < qn; j++) q[lo + j] = 0;
+            rem.swap(cur);
+        }
+        memset(u.data(), 0, n * sizeof(uint32_t));
+        memcpy(u.data(), rem.data(), rem.size() * sizeof(uint32_t));
+    }
+    if (shift) limbs_rshift(r, u.data(), n, shift);
+    else memcpy(r, u.data(), n * sizeof(uint32_t));
+}
+
+void limbs_divrem(uint32_t* q, uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+    bool large = bn >= NEWTON_DIV_THRESHOLD && an - bn + 1 >= NEWTON_DIV_THRESHOLD;
+    limb_divisor(b, bn, large).divrem(q, r, a, an);
+}
+
+// Decimal conversion: split by 10^(9 * 2^k), convert both halves independently.
+
+static uint32_t const DECIMAL_BASE = 1000000000;
+
+// powers[k] = 10^(9 * 2^k), for every k with 9 * 2^k < digits
+static vector<limb_vector> decimal_powers(size_t digits) {
+    vector<limb_vector> powers(1, limb_vector(1, DECIMAL_BASE));
+    while ((size_t(9) << powers.size()) < digits) {
+        powers.push_back(mul_vec(powers.back(), powers.back()));
+    }
+    return powers;
+}
+
+// largest k with 9 * 2^k < digits
+static size_t split_level(size_t digits) {
+    size_t k = 0;
+    while ((size_t(18) << k) < digits) k++;
+    return k;
+}
+
+// Writes a as exactly `width` digits ending at out + width; out is prefilled with '0'.
+static void to_decimal(char* out, size_t width, limb_vector a, vector<limb_divisor> const& divisors) {
+    trim(a);
+    if (a.size() < DC_CONVERSION_THRESHOLD || width <= 9) {
+        char* p = out + width;
+        while (!a.empty()) {
+            uint32_t rem = limbs_divrem_1(a.data(), a.data(), a.size(), DECIMAL_BASE);
+            trim(a);
+            for (int i = 0; i < 9 && p > out; i++, rem /= 10) *--p = static_cast<char>('0' + rem % 10);
+        }
+        return;
+    }
+    size_t k = split_level(width), low = size_t(9) << k;
+    limb_divisor const& d = divisors[k];
+    if (a.size() < d.size()) {
+        to_decimal(out + width - low, low, a, divisors);
+        return;
+    }
+    limb_vector q(a.size() - d.size() + 1), r(d.size());
+    d.divrem(q.data(), r.data(), a.data(), a.size());
+    task_group group;
+    if (a.size() >= PARALLEL_CONVERSION_THRESHOLD) {
+        group.run([&]() { to_decimal(out, width - low, q, divisors); });
+    } else {
+        to_decimal(out, width - low, q, divisors);
+    }
+    to_decimal(out + width - low, low, r, divisors);
+    group.wait();
+}
+
+void limbs_to_decimal(string& out, uint32_t const* a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) n--;
+    if (n == 0) {
+        out.push_back('0');
+        return;
+    }
+    // 2^(32n) < 10^(9.64n + 1)
+    size_t width = n * 964 / 100 + 1;
+    vector<limb_vector> powers = decimal_powers(width);
+    vector<limb_divisor> divisors;
+    for (size_t k = 0; k < powers.size(); k++) {
+        divisors.push_back(limb_divisor(powers[k].data(), powers[k].size()));
+    }
+    size_t start = out.size();
+    out.resize(start + width, '0');
+    to_decimal(&out[start], width, limb_vector(a, a + n), divisors);
+    size_t zeros = 0;
+    while (zeros + 1 < width && out[start + zeros] == '0') zeros++;
+    out.erase(start, zeros);
+}
+
+static limb_vector from_decimal(char const* s, size_t len, vector<limb_vector> const& powers) {
+    if (len <= 9 * DC_CONVERSION_THRESHOLD) {
+        limb_vector r(len / 9 + 2, 0);
+        size_t used = 0;
+        for (size_t i = 0; i < len;) {
+            size_t chunk = (i == 0 && len % 9) ? len % 9 : 9;
+            uint32_t value = 0, scale = 1;
+            for (size_t j = 0; j < chunk; j++, i++) {
+                value = value * 10 + static_cast<uint32_t>(s[i] - '0');
+                scale *= 10;
+            }
+            r[used] = limbs_mul_1(r.data(), r.data(), used, scale);
+            add_into(r.data(), used + 1, &value, 1);
+            if (r[used] != 0) used++;
+        }
+        trim(r);
+        return r;
+    }
+    size_t k = split_level(len), low = size_t(9) << k;
+    limb_vector hi, lo;
+    task_group group;
+    if (len >= PARALLEL_CONVERSION_THRESHOLD * 9) {
+        group.run([&]() { hi = from_decimal(s, len - low, powers); });
+    } else {
+        hi = from_decimal(s, len - low, powers);
+    }
+    lo = from_decimal(s + len - low, low, powers);
+    group.wait();
+    limb_vector r = mul_vec(hi, powers[k]);
+    add_vec(r, lo);
+    return r;
+}
+
+vector<uint32_t> limbs_from_decimal(char const* s, size_t len) {
+    return from_decimal(s, len, decimal_powers(len));
+}
@@ -0,0 +1,59 @@
+#ifndef LIMB_ARITH_H
+#define LIMB_ARITH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Magnitude algorithms over raw limb arrays, built on top of limb_kernels.
+
+// Below this many limbs in the shorter operand multiplication is schoolbook.
+const size_t KARATSUBA_THRESHOLD = 32;
+// Squaring halves the schoolbook work, so it stays schoolbook a little longer.
+const size_t SQR_KARATSUBA_THRESHOLD = 48;
+// Below this many limbs in the shorter operand multiplication never leaves the calling thread.
+const size_t PARALLEL_MUL_THRESHOLD = 2048;
+// Below this many limbs in the divisor or the quotient division is schoolbook (Knuth's
+// algorithm D); above it, it multiplies by a Newton reciprocal of the divisor.
+const size_t NEWTON_DIV_THRESHOLD = 80;
+// Decimal conversion splits numbers down to this many limbs, and hands halves to other
+// threads while they are at least PARALLEL_CONVERSION_THRESHOLD limbs long.
+const size_t DC_CONVERSION_THRESHOLD = 30;
+const size_t PARALLEL_CONVERSION_THRESHOLD = 512;
+
+int limbs_cmp(uint32_t const* a, uint32_t const* b, size_t n);
+
+// r[0, an + bn) = a * b, an >= bn > 0. r must not overlap a or b.
+// Squares (a == b, an == bn) are passed on to limbs_sqr.
+void limbs_mul(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn);
+// r[0, 2n) = a * a, n > 0. r must not overlap a.
+void limbs_sqr(uint32_t* r, uint32_t const* a, size_t n);
+
+// q = a / d, returns a % d. q may alias a.
+uint32_t limbs_divrem_1(uint32_t* q, uint32_t const* a, size_t n, uint32_t d);
+
+// q[0, an - bn + 1) = a / b, r[0, bn) = a % b; an >= bn > 0, b[bn - 1] != 0.
+// q and r must not overlap the inputs.
+void limbs_divrem(uint32_t* q, uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn);
+
+// A divisor prepared once for many divisions: normalized, and, when it is long enough,
+// with its reciprocal floor((B^2n - 1) / d) computed by Newton iteration.
+struct limb_divisor {
+    limb_divisor(uint32_t const* d, size_t n, bool with_inverse = true);
+    size_t size() const;
+    // same contract as limbs_divrem
+    void divrem(uint32_t* q, uint32_t* r, uint32_t const* a, size_t an) const;
+
+private:
+    unsigned shift;
+    std::vector<uint32_t> norm;
+    std::vector<uint32_t> inverse;
+};
+
+// Appends the decimal digits of a[0, n) to out, without leading zeros.
+void limbs_to_decimal(std::string& out, uint32_t const* a, size_t n);
+// Magnitude of the decimal digits s[0, len), which must all be '0'..'9'. Not trimmed.
+std::vector<uint32_t> limbs_from_decimal(char const* s, size_t len);
+
+#endif
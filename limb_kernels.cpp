@@ -0,0 +1,672 @@
+#include "limb_kernels.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define LIMB_KERNELS_X86
+#include <immintrin.h>
+// lets the target-specific clones below inline the scalar bodies and compile them for their ISA
+#define KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define KERNEL_INLINE inline
+#endif
+
+// scalar
+
+static KERNEL_INLINE uint32_t add_n_scalar(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t sum = carry + a[i] + b[i];
+        dst[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+static KERNEL_INLINE uint32_t sub_n_scalar(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t diff = uint64_t(a[i]) - b[i] - borrow;
+        dst[i] = static_cast<uint32_t>(diff);
+        borrow = (diff >> 32) & 1;
+    }
+    return static_cast<uint32_t>(borrow);
+}
+
+static KERNEL_INLINE uint32_t mul_1_scalar(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t t = uint64_t(a[i]) * b + carry;
+        dst[i] = static_cast<uint32_t>(t);
+        carry = t >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+static KERNEL_INLINE uint32_t addmul_1_scalar(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t t = uint64_t(a[i]) * b + dst[i] + carry;
+        dst[i] = static_cast<uint32_t>(t);
+        carry = t >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+static void and_scalar(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = a[i] & b[i];
+}
+
+static void or_scalar(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = a[i] | b[i];
+}
+
+static void xor_scalar(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = a[i] ^ b[i];
+}
+
+static void not_scalar(uint32_t* dst, uint32_t const* a, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = ~a[i];
+}
+
+static KERNEL_INLINE unsigned popcount_32(uint32_t x) {
+    x = x - ((x >> 1) & 0x55555555);
+    x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+    x = (x + (x >> 4)) & 0x0f0f0f0f;
+    return (x * 0x01010101) >> 24;
+}
+
+// The popcount kernels share one body each, which counts a ^ b when b is given and a alone
+// for b == nullptr; the test folds away in popcount and is hoisted out of the loop in hamming.
+static KERNEL_INLINE size_t popcount_scalar_body(uint32_t const* a, uint32_t const* b, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) count += popcount_32(b ? a[i] ^ b[i] : a[i]);
+    return count;
+}
+
+static size_t popcount_scalar(uint32_t const* a, size_t n) {
+    return popcount_scalar_body(a, nullptr, n);
+}
+
+static size_t hamming_scalar(uint32_t const* a, uint32_t const* b, size_t n) {
+    return popcount_scalar_body(a, b, n);
+}
+
+static uint32_t lshift_scalar(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift) {
+    unsigned back = 32 - shift;
+    uint32_t out = src[n - 1] >> back;
+    for (size_t i = n - 1; i > 0; i--) {
+        dst[i] = (src[i] << shift) | (src[i - 1] >> back);
+    }
+    dst[0] = src[0] << shift;
+    return out;
+}
+
+static uint32_t rshift_scalar(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift) {
+    unsigned back = 32 - shift;
+    uint32_t out = src[0] << back;
+    for (size_t i = 0; i + 1 < n; i++) {
+        dst[i] = (src[i] >> shift) | (src[i + 1] << back);
+    }
+    dst[n - 1] = src[n - 1] >> shift;
+    return out;
+}
+
+static KERNEL_INLINE uint32_t submul_1_scalar(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t t = uint64_t(a[i]) * b + borrow;
+        uint32_t lo = static_cast<uint32_t>(t);
+        borrow = (t >> 32) + (dst[i] < lo);
+        dst[i] -= lo;
+    }
+    return static_cast<uint32_t>(borrow);
+}
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 uint128_t;
+#endif
+
+// returns the low word of a * b + c + d and stores the high word, which cannot overflow, in hi
+static KERNEL_INLINE uint64_t mul_add_64(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t& hi) {
+#ifdef __SIZEOF_INT128__
+    uint128_t t = uint128_t(a) * b + c + d;
+    hi = static_cast<uint64_t>(t >> 64);
+    return static_cast<uint64_t>(t);
+#else
+    uint64_t al = a & 0xffffffff, ah = a >> 32, bl = b & 0xffffffff, bh = b >> 32;
+    uint64_t ll = al * bl, lh = al * bh, hl = ah * bl;
+    uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    uint64_t lo = (mid << 32) | (ll & 0xffffffff);
+    hi = ah * bh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    lo += c;
+    hi += (lo < c);
+    lo += d;
+    hi += (lo < d);
+    return lo;
+#endif
+}
+
+// Coarsely integrated operand scanning: every row adds a * b[i] and then u * m, with u chosen
+// so that the low word cancels, and shifts t down one word. t stays below 2m throughout.
+static KERNEL_INLINE void mont_mul_scalar(uint64_t* r, uint64_t const* a, uint64_t const* b, uint64_t const* m,
+                                          size_t n, uint64_t m_inv, uint64_t* t) {
+    memset(t, 0, (n + 2) * sizeof(uint64_t));
+    for (size_t i = 0; i < n; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < n; j++) t[j] = mul_add_64(a[j], b[i], t[j], carry, carry);
+        t[n] = mul_add_64(0, 0, t[n], carry, t[n + 1]);
+
+        uint64_t u = t[0] * m_inv;
+        mul_add_64(u, m[0], t[0], 0, carry);
+        for (size_t j = 1; j < n; j++) t[j - 1] = mul_add_64(u, m[j], t[j], carry, carry);
+        t[n - 1] = mul_add_64(0, 0, t[n], carry, carry);
+        t[n] = t[n + 1] + carry;
+    }
+    uint64_t borrow = 0;
+    for (size_t j = 0; j < n; j++) {
+        uint64_t d = t[j] - m[j] - borrow;
+        borrow = (t[j] < m[j]) || (t[j] == m[j] && borrow);
+        r[j] = d;
+    }
+    // t < m exactly when the subtraction borrows out of the top word
+    if (borrow > t[n]) memcpy(r, t, n * sizeof(uint64_t));
+}
+
+#ifdef LIMB_KERNELS_X86
+
+// Carry chains are serial, so the vector variants of the arithmetic kernels are the scalar
+// loops recompiled for the target (which, among other things, lets the compiler use mulx).
+
+#define ARITH_CLONES(suffix, isa)                                                              \
+__attribute__((target(isa)))                                                                   \
+static uint32_t add_n_##suffix(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) { \
+    return add_n_scalar(dst, a, b, n);                                                         \
+}                                                                                              \
+__attribute__((target(isa)))                                                                   \
+static uint32_t sub_n_##suffix(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) { \
+    return sub_n_scalar(dst, a, b, n);                                                         \
+}                                                                                              \
+__attribute__((target(isa)))                                                                   \
+static uint32_t mul_1_##suffix(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b) {       \
+    return mul_1_scalar(dst, a, n, b);                                                         \
+}                                                                                              \
+__attribute__((target(isa)))                                                                   \
+static uint32_t addmul_1_##suffix(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b) {    \
+    return addmul_1_scalar(dst, a, n, b);                                                      \
+}                                                                                              \
+__attribute__((target(isa)))                                                                   \
+static uint32_t submul_1_##suffix(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b) {    \
+    return submul_1_scalar(dst, a, n, b);                                                      \
+}                                                                                              \
+__attribute__((target(isa)))                                                                   \
+static void mont_mul_##suffix(uint64_t* r, uint64_t const* a, uint64_t const* b,               \
+                              uint64_t const* m, size_t n, uint64_t m_inv, uint64_t* t) {      \
+    mont_mul_scalar(r, a, b, m, n, m_inv, t);                                                  \
+}
+
+ARITH_CLONES(sse42, "sse4.2")
+ARITH_CLONES(avx2, "avx2,bmi2")
+ARITH_CLONES(avx512, "avx512f,avx2,bmi2")
+
+// SSE4.2: 4 limbs per instruction
+
+#define SSE42_LOGIC(name, op, sop)                                                             \
+__attribute__((target("sse4.2")))                                                              \
+static void name(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {              \
+    size_t i = 0;                                                                              \
+    for (; i + 4 <= n; i += 4) {                                                               \
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));                  \
+        __m128i y = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));                  \
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), op(x, y));                       \
+    }                                                                                          \
+    for (; i < n; i++) dst[i] = a[i] sop b[i];                                                 \
+}
+
+SSE42_LOGIC(and_sse42, _mm_and_si128, &)
+SSE42_LOGIC(or_sse42, _mm_or_si128, |)
+SSE42_LOGIC(xor_sse42, _mm_xor_si128, ^)
+
+__attribute__((target("sse4.2")))
+static void not_sse42(uint32_t* dst, uint32_t const* a, size_t n) {
+    __m128i ones = _mm_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(x, ones));
+    }
+    for (; i < n; i++) dst[i] = ~a[i];
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t lshift_sse42(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift) {
+    unsigned back = 32 - shift;
+    uint32_t out = src[n - 1] >> back;
+    __m128i sl = _mm_cvtsi32_si128(static_cast<int>(shift));
+    __m128i sr = _mm_cvtsi32_si128(static_cast<int>(back));
+    size_t i = n;
+    while (i >= 5) {
+        i -= 4;
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i - 1));
+        __m128i r = _mm_or_si128(_mm_sll_epi32(hi, sl), _mm_srl_epi32(lo, sr));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), r);
+    }
+    for (; i > 1; i--) {
+        dst[i - 1] = (src[i - 1] << shift) | (src[i - 2] >> back);
+    }
+    dst[0] = src[0] << shift;
+    return out;
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t rshift_sse42(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift) {
+    unsigned back = 32 - shift;
+    uint32_t out = src[0] << back;
+    __m128i sr = _mm_cvtsi32_si128(static_cast<int>(shift));
+    __m128i sl = _mm_cvtsi32_si128(static_cast<int>(back));
+    size_t i = 0;
+    for (; i + 4 < n; i += 4) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i + 1));
+        __m128i r = _mm_or_si128(_mm_srl_epi32(lo, sr), _mm_sll_epi32(hi, sl));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), r);
+    }
+    for (; i + 1 < n; i++) {
+        dst[i] = (src[i] >> shift) | (src[i + 1] << back);
+    }
+    dst[n - 1] = src[n - 1] >> shift;
+    return out;
+}
+
+// the popcnt instruction, on two limbs at a time
+__attribute__((target("popcnt")))
+static KERNEL_INLINE size_t popcount_popcnt_body(uint32_t const* a, uint32_t const* b, size_t n) {
+    size_t count = 0, i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint64_t x, y;
+        memcpy(&x, a + i, sizeof(x));
+        if (b) {
+            memcpy(&y, b + i, sizeof(y));
+            x ^= y;
+        }
+        count += __builtin_popcountll(x);
+    }
+    if (i < n) count += __builtin_popcount(b ? a[i] ^ b[i] : a[i]);
+    return count;
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static size_t popcount_sse42(uint32_t const* a, size_t n) {
+    return popcount_popcnt_body(a, nullptr, n);
+}
+
+__attribute__((target("sse4.2,popcnt")))
+static size_t hamming_sse42(uint32_t const* a, uint32_t const* b, size_t n) {
+    return popcount_popcnt_body(a, b, n);
+}
+
+// AVX2: 8 limbs per instruction
+
+#define AVX2_LOGIC(name, op, sop)                                                              \
+__attribute__((target("avx2")))                                                                \
+static void name(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {              \
+    size_t i = 0;                                                                              \
+    for (; i + 8 <= n; i += 8) {                                                               \
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));               \
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i));               \
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), op(x, y));                    \
+    }                                                                                          \
+    for (; i < n; i++) dst[i] = a[i] sop b[i];                                                 \
+}
+
+AVX2_LOGIC(and_avx2, _mm256_and_si256, &)
+AVX2_LOGIC(or_avx2, _mm256_or_si256, |)
+AVX2_LOGIC(xor_avx2, _mm256_xor_si256, ^)
+
+__attribute__((target("avx2")))
+static void not_avx2(uint32_t* dst, uint32_t const* a, size_t n) {
+    __m256i ones = _mm256_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(x, ones));
+    }
+    for (; i < n; i++) dst[i] = ~a[i];
+}
+
+__attribute__((target("avx2")))
+static uint32_t lshift_avx2(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift) {
+    unsigned back = 32 - shift;
+    uint32_t out = src[n - 1] >> back;
+    __m128i sl = _mm_cvtsi32_si128(static_cast<int>(shift));
+    __m128i sr = _mm_cvtsi32_si128(static_cast<int>(back));
+    // walk downwards so that dst >= src overlap is safe
+    size_t i = n;
+    while (i >= 9) {
+        i -= 8;
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i - 1));
+        __m256i r = _mm256_or_si256(_mm256_sll_epi32(hi, sl), _mm256_srl_epi32(lo, sr));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), r);
+    }
+    for (; i > 1; i--) {
+        dst[i - 1] = (src[i - 1] << shift) | (src[i - 2] >> back);
+    }
+    dst[0] = src[0] << shift;
+    return out;
+}
+
+__attribute__((target("avx2")))
+static uint32_t rshift_avx2(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift) {
+    unsigned back = 32 - shift;
+    uint32_t out = src[0] << back;
+    __m128i sr = _mm_cvtsi32_si128(static_cast<int>(shift));
+    __m128i sl = _mm_cvtsi32_si128(static_cast<int>(back));
+    size_t i = 0;
+    for (; i + 8 < n; i += 8) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i + 1));
+        __m256i r = _mm256_or_si256(_mm256_srl_epi32(lo, sr), _mm256_sll_epi32(hi, sl));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), r);
+    }
+    for (; i + 1 < n; i++) {
+        dst[i] = (src[i] >> shift) | (src[i + 1] << back);
+    }
+    dst[n - 1] = src[n - 1] >> shift;
+    return out;
+}
+
+// Mula's popcount: the counts of the two nibbles of every byte are looked up with vpshufb
+// and summed per 64-bit lane by vpsadbw.
+__attribute__((target("avx2,popcnt")))
+static KERNEL_INLINE size_t popcount_avx2_body(uint32_t const* a, uint32_t const* b, size_t n) {
+    __m256i const table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    __m256i const low = _mm256_set1_epi8(0x0f);
+    __m256i sum = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));
+        if (b) x = _mm256_xor_si256(x, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i)));
+        __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(table, _mm256_and_si256(x, low)),
+                                        _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(x, 4), low)));
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+    size_t count = _mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1) + _mm256_extract_epi64(sum, 2) +
+                   _mm256_extract_epi64(sum, 3);
+    return count + popcount_popcnt_body(a + i, b ? b + i : nullptr, n - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t popcount_avx2(uint32_t const* a, size_t n) {
+    return popcount_avx2_body(a, nullptr, n);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t hamming_avx2(uint32_t const* a, uint32_t const* b, size_t n) {
+    return popcount_avx2_body(a, b, n);
+}
+
+// AVX-512: 16 limbs per instruction
+
+#define AVX512_LOGIC(name, op, sop)                                                            \
+__attribute__((target("avx512f")))                                                             \
+static void name(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {              \
+    size_t i = 0;                                                                              \
+    for (; i + 16 <= n; i += 16) {                                                             \
+        __m512i x = _mm512_loadu_si512(a + i);                                                 \
+        __m512i y = _mm512_loadu_si512(b + i);                                                 \
+        _mm512_storeu_si512(dst + i, op(x, y));                                                \
+    }                                                                                          \
+    for (; i < n; i++) dst[i] = a[i] sop b[i];                                                 \
+}
+
+AVX512_LOGIC(and_avx512, _mm512_and_si512, &)
+AVX512_LOGIC(or_avx512, _mm512_or_si512, |)
+AVX512_LOGIC(xor_avx512, _mm512_xor_si512, ^)
+
+__attribute__((target("avx512f")))
+static void not_avx512(uint32_t* dst, uint32_t const* a, size_t n) {
+    __m512i ones = _mm512_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_si512(dst + i, _mm512_xor_si512(_mm512_loadu_si512(a + i), ones));
+    }
+    for (; i < n; i++) dst[i] = ~a[i];
+}
+
+__attribute__((target("avx512f")))
+static uint32_t lshift_avx512(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift) {
+    unsigned back = 32 - shift;
+    uint32_t out = src[n - 1] >> back;
+    __m128i sl = _mm_cvtsi32_si128(static_cast<int>(shift));
+    __m128i sr = _mm_cvtsi32_si128(static_cast<int>(back));
+    __mmask16 const all = 0xffff; // the unmasked forms trip gcc's -Wmaybe-uninitialized
+    size_t i = n;
+    while (i >= 17) {
+        i -= 16;
+        __m512i hi = _mm512_loadu_si512(src + i);
+        __m512i lo = _mm512_loadu_si512(src + i - 1);
+        __m512i r = _mm512_or_si512(_mm512_maskz_sll_epi32(all, hi, sl), _mm512_maskz_srl_epi32(all, lo, sr));
+        _mm512_storeu_si512(dst + i, r);
+    }
+    for (; i > 1; i--) {
+        dst[i - 1] = (src[i - 1] << shift) | (src[i - 2] >> back);
+    }
+    dst[0] = src[0] << shift;
+    return out;
+}
+
+__attribute__((target("avx512f")))
+static uint32_t rshift_avx512(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift) {
+    unsigned back = 32 - shift;
+    uint32_t out = src[0] << back;
+    __m128i sr = _mm_cvtsi32_si128(static_cast<int>(shift));
+    __m128i sl = _mm_cvtsi32_si128(static_cast<int>(back));
+    __mmask16 const all = 0xffff;
+    size_t i = 0;
+    for (; i + 16 < n; i += 16) {
+        __m512i lo = _mm512_loadu_si512(src + i);
+        __m512i hi = _mm512_loadu_si512(src + i + 1);
+        __m512i r = _mm512_or_si512(_mm512_maskz_srl_epi32(all, lo, sr), _mm512_maskz_sll_epi32(all, hi, sl));
+        _mm512_storeu_si512(dst + i, r);
+    }
+    for (; i + 1 < n; i++) {
+        dst[i] = (src[i] >> shift) | (src[i + 1] << back);
+    }
+    dst[n - 1] = src[n - 1] >> shift;
+    return out;
+}
+
+// VPOPCNTDQ counts the bits of 64-bit lanes directly. It is an extension of its own, so the
+// avx512 table checks for it once and otherwise counts as avx2 does.
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+static KERNEL_INLINE size_t popcount_vpopcnt_body(uint32_t const* a, uint32_t const* b, size_t n) {
+    __m512i sum = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        if (b) x = _mm512_xor_si512(x, _mm512_loadu_si512(b + i));
+        sum = _mm512_add_epi64(sum, _mm512_popcnt_epi64(x));
+    }
+    uint64_t lanes[8]; // _mm512_reduce_add_epi64 trips gcc's -Wuninitialized
+    _mm512_storeu_si512(lanes, sum);
+    size_t count = 0;
+    for (int j = 0; j < 8; j++) count += lanes[j];
+    return count + popcount_popcnt_body(a + i, b ? b + i : nullptr, n - i);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+static size_t popcount_vpopcnt(uint32_t const* a, size_t n) {
+    return popcount_vpopcnt_body(a, nullptr, n);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+static size_t hamming_vpopcnt(uint32_t const* a, uint32_t const* b, size_t n) {
+    return popcount_vpopcnt_body(a, b, n);
+}
+
+static bool has_vpopcntdq() {
+    static bool const supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx512vpopcntdq"));
+    return supported;
+}
+
+static size_t popcount_avx512(uint32_t const* a, size_t n) {
+    return has_vpopcntdq() ? popcount_vpopcnt(a, n) : popcount_avx2(a, n);
+}
+
+static size_t hamming_avx512(uint32_t const* a, uint32_t const* b, size_t n) {
+    return has_vpopcntdq() ? hamming_vpopcnt(a, b, n) : hamming_avx2(a, b, n);
+}
+
+#endif
+
+// dispatch
+
+static limb_kernels const scalar_kernels = {
+    "scalar", add_n_scalar, sub_n_scalar, mul_1_scalar, addmul_1_scalar, submul_1_scalar, mont_mul_scalar,
+    lshift_scalar, rshift_scalar,
+    and_scalar, or_scalar, xor_scalar, not_scalar,
+    popcount_scalar, hamming_scalar
+};
+
+#ifdef LIMB_KERNELS_X86
+static limb_kernels const sse42_kernels = {
+    "sse4.2", add_n_sse42, sub_n_sse42, mul_1_sse42, addmul_1_sse42, submul_1_sse42, mont_mul_sse42,
+    lshift_sse42, rshift_sse42,
+    and_sse42, or_sse42, xor_sse42, not_sse42,
+    popcount_sse42, hamming_sse42
+};
+
+static limb_kernels const avx2_kernels = {
+    "avx2", add_n_avx2, sub_n_avx2, mul_1_avx2, addmul_1_avx2, submul_1_avx2, mont_mul_avx2,
+    lshift_avx2, rshift_avx2,
+    and_avx2, or_avx2, xor_avx2, not_avx2,
+    popcount_avx2, hamming_avx2
+};
+
+static limb_kernels const avx512_kernels = {
+    "avx512", add_n_avx512, sub_n_avx512, mul_1_avx512, addmul_1_avx512, submul_1_avx512, mont_mul_avx512,
+    lshift_avx512, rshift_avx512,
+    and_avx512, or_avx512, xor_avx512, not_avx512,
+    popcount_avx512, hamming_avx512
+};
+#endif
+
+// best first
+static limb_kernels const* const all_kernels[] = {
+#ifdef LIMB_KERNELS_X86
+    &avx512_kernels, &avx2_kernels, &sse42_kernels,
+#endif
+    &scalar_kernels
+};
+
+static bool cpu_supports(limb_kernels const* k) {
+#ifdef LIMB_KERNELS_X86
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("popcnt");
+    if (k == &avx512_kernels) return avx2 && __builtin_cpu_supports("avx512f");
+    if (k == &avx2_kernels) return avx2;
+    if (k == &sse42_kernels) return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+#endif
+    return k == &scalar_kernels;
+}
+
+static limb_kernels const* find_kernels(char const* name) {
+    size_t count = sizeof(all_kernels) / sizeof(all_kernels[0]);
+    if (strcmp(name, "auto") == 0) {
+        for (size_t i = 0; i < count; i++) {
+            if (cpu_supports(all_kernels[i])) return all_kernels[i];
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(name, all_kernels[i]->name) == 0) {
+            return cpu_supports(all_kernels[i]) ? all_kernels[i] : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+static limb_kernels const* initial_kernels() {
+    char const* pinned = getenv("BIGINT_KERNELS");
+    if (pinned != nullptr && *pinned != '\0') {
+        limb_kernels const* k = find_kernels(pinned);
+        if (k != nullptr) return k;
+    }
+    return find_kernels("auto");
+}
+
+static std::atomic<limb_kernels const*>& current_kernels() {
+    static std::atomic<limb_kernels const*> k(initial_kernels());
+    return k;
+}
+
+limb_kernels const& active_kernels() {
+    return *current_kernels().load(std::memory_order_relaxed);
+}
+
+bool select_kernels(char const* name) {
+    limb_kernels const* k = find_kernels(name);
+    if (k == nullptr) return false;
+    current_kernels().store(k, std::memory_order_relaxed);
+    return true;
+}
+
+uint32_t limbs_add(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {
+    return active_kernels().add_n(dst, a, b, n);
+}
+
+uint32_t limbs_sub(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {
+    return active_kernels().sub_n(dst, a, b, n);
+}
+
+uint32_t limbs_mul_1(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b) {
+    return active_kernels().mul_1(dst, a, n, b);
+}
+
+uint32_t limbs_addmul_1(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b) {
+    return active_kernels().addmul_1(dst, a, n, b);
+}
+
+uint32_t limbs_submul_1(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b) {
+    return active_kernels().submul_1(dst, a, n, b);
+}
+
+void limbs_mont_mul(uint64_t* r, uint64_t const* a, uint64_t const* b, uint64_t const* m, size_t n,
+                    uint64_t m_inv, uint64_t* t) {
+    active_kernels().mont_mul(r, a, b, m, n, m_inv, t);
+}
+
+void limbs_and(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {
+    active_kernels().and_n(dst, a, b, n);
+}
+
+void limbs_or(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {
+    active_kernels().or_n(dst, a, b, n);
+}
+
+void limbs_xor(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n) {
+    active_kernels().xor_n(dst, a, b, n);
+}
+
+void limbs_not(uint32_t* dst, uint32_t const* a, size_t n) {
+    active_kernels().not_n(dst, a, n);
+}
+
+uint32_t limbs_lshift(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift) {
+    return active_kernels().lshift(dst, src, n, shift);
+}
+
+uint32_t limbs_rshift(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift) {
+    return active_kernels().rshift(dst, src, n, shift);
+}
+
+size_t limbs_popcount(uint32_t const* a, size_t n) {
+    return active_kernels().popcount(a, n);
+}
+
+size_t limbs_hamming(uint32_t const* a, uint32_t const* b, size_t n) {
+    return active_kernels().hamming(a, b, n);
+}
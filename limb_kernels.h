@@ -0,0 +1,73 @@
+#ifndef LIMB_KERNELS_H
+#define LIMB_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels over raw little-endian arrays of 32-bit limbs.
+// Every function processes exactly n limbs; sign extension is the caller's job.
+
+// dst = a + b, returns the carry. dst may alias a or b.
+uint32_t limbs_add(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n);
+// dst = a - b, returns the borrow. dst may alias a or b.
+uint32_t limbs_sub(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n);
+// dst = a * b, returns the high limb. dst may alias a.
+uint32_t limbs_mul_1(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b);
+// dst += a * b, returns the high limb.
+uint32_t limbs_addmul_1(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b);
+// dst -= a * b, returns the high limb to subtract from above dst.
+uint32_t limbs_submul_1(uint32_t* dst, uint32_t const* a, size_t n, uint32_t b);
+
+void limbs_and(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n);
+void limbs_or(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n);
+void limbs_xor(uint32_t* dst, uint32_t const* a, uint32_t const* b, size_t n);
+void limbs_not(uint32_t* dst, uint32_t const* a, size_t n);
+
+// Number of one bits of a, and of a ^ b, without forming a ^ b.
+size_t limbs_popcount(uint32_t const* a, size_t n);
+size_t limbs_hamming(uint32_t const* a, uint32_t const* b, size_t n);
+
+// dst = src << shift, 0 < shift < 32, n > 0. Returns the bits shifted out of the top limb.
+// dst may overlap src if dst >= src.
+uint32_t limbs_lshift(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift);
+
+// dst = src >> shift, 0 < shift < 32, n > 0. Returns the bits shifted out of the bottom limb
+// (in the high bits of the result). dst may overlap src if dst <= src.
+uint32_t limbs_rshift(uint32_t* dst, uint32_t const* src, size_t n, unsigned shift);
+
+// Montgomery multiplication on 64-bit words: r = a * b * 2^(-64n) mod m for odd m, a, b < m
+// and m_inv = -m^-1 mod 2^64. t is scratch of n + 2 words; r may alias a or b.
+void limbs_mont_mul(uint64_t* r, uint64_t const* a, uint64_t const* b, uint64_t const* m, size_t n,
+                    uint64_t m_inv, uint64_t* t);
+
+// One implementation of every kernel, built for a particular instruction set.
+struct limb_kernels {
+    char const* name;
+    uint32_t (*add_n)(uint32_t*, uint32_t const*, uint32_t const*, size_t);
+    uint32_t (*sub_n)(uint32_t*, uint32_t const*, uint32_t const*, size_t);
+    uint32_t (*mul_1)(uint32_t*, uint32_t const*, size_t, uint32_t);
+    uint32_t (*addmul_1)(uint32_t*, uint32_t const*, size_t, uint32_t);
+    uint32_t (*submul_1)(uint32_t*, uint32_t const*, size_t, uint32_t);
+    void (*mont_mul)(uint64_t*, uint64_t const*, uint64_t const*, uint64_t const*, size_t, uint64_t, uint64_t*);
+    uint32_t (*lshift)(uint32_t*, uint32_t const*, size_t, unsigned);
+    uint32_t (*rshift)(uint32_t*, uint32_t const*, size_t, unsigned);
+    void (*and_n)(uint32_t*, uint32_t const*, uint32_t const*, size_t);
+    void (*or_n)(uint32_t*, uint32_t const*, uint32_t const*, size_t);
+    void (*xor_n)(uint32_t*, uint32_t const*, uint32_t const*, size_t);
+    void (*not_n)(uint32_t*, uint32_t const*, size_t);
+    size_t (*popcount)(uint32_t const*, size_t);
+    size_t (*hamming)(uint32_t const*, uint32_t const*, size_t);
+};
+
+// The table the limbs_* functions above dispatch through. On first use it is set to the
+// best variant this CPU supports, unless the BIGINT_KERNELS environment variable pins one
+// of "scalar", "sse4.2", "avx2" or "avx512". A name that is unknown or that the CPU cannot
+// run falls back to detection silently; active_kernels().name tells which one is in use.
+limb_kernels const& active_kernels();
+
+// Switches the active table; "auto" restores cpuid detection. Returns false (and changes
+// nothing) if the name is unknown or the CPU lacks the instructions. Not safe to call while
+// other threads are running big_integer operations.
+bool select_kernels(char const* name);
+
+#endif
@@ -0,0 +1,316 @@
+#include "modular.h"
+#include "limb_arith.h"
+#include "limb_kernels.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+static size_t trimmed_size(fast_vector const& a) {
+    size_t n = a.size();
+    while (n > 0 && a[n - 1] == 0) n--;
+    return n;
+}
+
+static bool test_limb_bit(uint32_t const* e, size_t i) {
+    return (e[i / 32] >> (i % 32)) & 1;
+}
+
+// Window width for sliding-window exponentiation by exponent size, as in OpenSSL.
+static unsigned window_bits(size_t bits) {
+    return bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : 1;
+}
+
+// acc = base^e for the n-limb residues of some ring, given by mul(r, a, b) which may alias.
+// e[0, en) is trimmed and nonzero. Odd powers base^1, base^3, ... are tabulated and the
+// exponent is scanned from the top in windows that start and end with a set bit.
+template<typename Word, typename Mul>
+static void window_pow(size_t n, Word* acc, Word const* base, uint32_t const* e, size_t en, Mul const& mul) {
+    size_t bits = en * 32;
+    while (!test_limb_bit(e, bits - 1)) bits--;
+    unsigned w = window_bits(bits);
+
+    vector<Word> table(n << (w - 1));
+    memcpy(table.data(), base, n * sizeof(Word));
+    if (w > 1) {
+        vector<Word> sq(n);
+        mul(sq.data(), base, base);
+        for (size_t i = 1; i < (size_t(1) << (w - 1)); i++) mul(&table[i * n], &table[(i - 1) * n], sq.data());
+    }
+
+    bool started = false;
+    for (size_t i = bits; i > 0;) {
+        if (!test_limb_bit(e, i - 1)) {
+            mul(acc, acc, acc);
+            i--;
+            continue;
+        }
+        size_t low = (i > w) ? i - w : 0;
+        while (!test_limb_bit(e, low)) low++;
+        size_t value = 0;
+        for (size_t j = i; j > low; j--) value = (value << 1) | test_limb_bit(e, j - 1);
+        if (started) {
+            for (size_t j = low; j < i; j++) mul(acc, acc, acc);
+            mul(acc, acc, &table[(value >> 1) * n]);
+        } else {
+            memcpy(acc, &table[(value >> 1) * n], n * sizeof(Word));
+            started = true;
+        }
+        i = low;
+    }
+}
+
+// 64-bit words of a[0, an), zero-padded to n words
+static vector<uint64_t> to_words(uint32_t const* a, size_t an, size_t n) {
+    vector<uint64_t> res(n, 0);
+    for (size_t i = 0; i < an; i++) res[i / 2] |= uint64_t(a[i]) << (32 * (i % 2));
+    return res;
+}
+
+static big_integer from_words(vector<uint64_t> const& a) {
+    fast_vector limbs(2 * a.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        limbs[2 * i] = static_cast<uint32_t>(a[i]);
+        limbs[2 * i + 1] = static_cast<uint32_t>(a[i] >> 32);
+    }
+    return big_integer(false, limbs);
+}
+
+montgomery_context::montgomery_context(big_integer const& modulus) : mod(modulus) {
+    if (modulus.sign || modulus.is_zero() || !(modulus.array[0] & 1) || modulus == 1)
+        throw runtime_error("montgomery modulus must be odd and greater than 1");
+    fast_vector const mm = modulus.array;
+    size_t limbs = trimmed_size(mm);
+    n = (limbs + 1) / 2;
+    m = to_words(mm.data(), limbs, n);
+
+    // Newton's iteration doubles the correct low bits of m^-1, starting from 3
+    uint64_t inv = m[0];
+    for (int i = 0; i < 5; i++) inv *= 2 - m[0] * inv;
+    m_inv = 0 - inv;
+
+    vector<uint32_t> power(4 * n + 1, 0), q(4 * n + 2 - limbs), rem(limbs);
+    power[4 * n] = 1;
+    limbs_divrem(q.data(), rem.data(), power.data(), 4 * n + 1, mm.data(), limbs);
+    r2 = to_words(rem.data(), limbs, n);
+}
+
+big_integer const& montgomery_context::modulus() const {
+    return mod;
+}
+
+vector<uint64_t> montgomery_context::residue(big_integer const& a) const {
+    big_integer x = a % mod;
+    if (x.sign) x += mod;
+    fast_vector const xm = x.array;
+    return to_words(xm.data(), trimmed_size(xm), n);
+}
+
+big_integer montgomery_context::mul(big_integer const& a, big_integer const& b) const {
+    vector<uint64_t> x = residue(a), y = residue(b), t(n + 2);
+    // a * b * R^-1 * R^2 * R^-1 = a * b
+    limbs_mont_mul(x.data(), x.data(), y.data(), m.data(), n, m_inv, t.data());
+    limbs_mont_mul(x.data(), x.data(), r2.data(), m.data(), n, m_inv, t.data());
+    return from_words(x);
+}
+
+big_integer montgomery_context::pow(big_integer const& base, big_integer const& exp) const {
+    if (exp.sign) throw runtime_error("negative exponent");
+    fast_vector const e = exp.array;
+    size_t en = trimmed_size(e);
+    if (en == 0) return 1;
+
+    vector<uint64_t> x = residue(base), acc(n), one(n, 0), t(n + 2);
+    limbs_mont_mul(x.data(), x.data(), r2.data(), m.data(), n, m_inv, t.data());
+    window_pow(n, acc.data(), x.data(), e.data(), en, [&](uint64_t* r, uint64_t const* a, uint64_t const* b) {
+        limbs_mont_mul(r, a, b, m.data(), n, m_inv, t.data());
+    });
+    one[0] = 1;
+    limbs_mont_mul(acc.data(), acc.data(), one.data(), m.data(), n, m_inv, t.data());
+    return from_words(acc);
+}
+
+size_t montgomery_context::size() const {
+    return n;
+}
+
+vector<uint64_t> montgomery_context::to_montgomery(big_integer const& a) const {
+    vector<uint64_t> x = residue(a), t(n + 2);
+    limbs_mont_mul(x.data(), x.data(), r2.data(), m.data(), n, m_inv, t.data());
+    return x;
+}
+
+big_integer montgomery_context::from_montgomery(uint64_t const* x) const {
+    vector<uint64_t> res(n), one(n, 0), t(n + 2);
+    one[0] = 1;
+    limbs_mont_mul(res.data(), x, one.data(), m.data(), n, m_inv, t.data());
+    return from_words(res);
+}
+
+void montgomery_context::mul(uint64_t* r, uint64_t const* a, uint64_t const* b, uint64_t* t) const {
+    limbs_mont_mul(r, a, b, m.data(), n, m_inv, t);
+}
+
+void montgomery_context::add(uint64_t* r, uint64_t const* a, uint64_t const* b) const {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t s = a[i] + carry;
+        carry = (s < carry);
+        r[i] = s + b[i];
+        carry += (r[i] < s);
+    }
+    int cmp = 0;
+    for (size_t i = n; cmp == 0 && i > 0; i--) {
+        if (r[i - 1] != m[i - 1]) cmp = (r[i - 1] < m[i - 1]) ? -1 : 1;
+    }
+    if (!carry && cmp < 0) return;
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t d = r[i] - borrow;
+        borrow = (d > r[i]);
+        r[i] = d - m[i];
+        borrow += (r[i] > d);
+    }
+}
+
+void montgomery_context::sub(uint64_t* r, uint64_t const* a, uint64_t const* b) const {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t d = a[i] - borrow;
+        borrow = (d > a[i]);
+        r[i] = d - b[i];
+        borrow += (r[i] > d);
+    }
+    if (!borrow) return;
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t s = r[i] + carry;
+        carry = (s < carry);
+        r[i] = s + m[i];
+        carry += (r[i] < s);
+    }
+}
+
+// r[0, k) = a * b mod B^k
+static void mul_low(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t k) {
+    memset(r, 0, k * sizeof(uint32_t));
+    for (size_t j = 0; j < k; j++) limbs_addmul_1(r + j, a, k - j, b[j]);
+}
+
+// r[0, 2k) = a * b for a, b of k limbs, skipping the partial products below column k - 2.
+// They add up to less than k * B^(k - 1), which is below B^k for k < B, so r / B^k is
+// at most one short.
+static void mul_high(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t k) {
+    memset(r, 0, 2 * k * sizeof(uint32_t));
+    for (size_t j = 0; j < k; j++) {
+        size_t i = (j + 2 < k) ? k - 2 - j : 0;
+        r[j + k] = limbs_addmul_1(r + i + j, a + i, k - i, b[j]);
+    }
+}
+
+barrett_reducer::barrett_reducer(big_integer const& modulus) : mod(modulus) {
+    if (modulus.sign || modulus.is_zero()) throw runtime_error("modulus must be positive");
+    fast_vector const mm = modulus.array;
+    n = trimmed_size(mm);
+    m.assign(mm.data(), mm.data() + n);
+    m.push_back(0);
+    mu.resize(n + 1);
+    vector<uint32_t> top(2 * n, 0xffffffff), rem(n);
+    limbs_divrem(mu.data(), rem.data(), top.data(), 2 * n, m.data(), n);
+
+    acc.resize(n);
+    x.resize(n);
+    y.resize(n);
+    t.resize(2 * n);
+    q.resize(2 * n + 2);
+    r.resize(n + 1);
+}
+
+big_integer const& barrett_reducer::modulus() const {
+    return mod;
+}
+
+// HAC 14.42: the quotient estimate ((t / B^(n-1)) * mu) / B^(n+1) is short by a few units
+// at most, so the remainder is below B^(n+1) and it is enough to work modulo B^(n+1).
+void barrett_reducer::reduce_limbs(uint32_t* dst) {
+    if (n + 1 < 4 * KARATSUBA_THRESHOLD) mul_high(q.data(), t.data() + n - 1, mu.data(), n + 1);
+    else limbs_mul(q.data(), t.data() + n - 1, n + 1, mu.data(), n + 1);
+    mul_low(r.data(), q.data() + n + 1, m.data(), n + 1);
+    limbs_sub(r.data(), t.data(), r.data(), n + 1);
+    while (r[n] != 0 || limbs_cmp(r.data(), m.data(), n) >= 0) limbs_sub(r.data(), r.data(), m.data(), n + 1);
+    memcpy(dst, r.data(), n * sizeof(uint32_t));
+}
+
+void barrett_reducer::mul_limbs(uint32_t* dst, uint32_t const* a, uint32_t const* b) {
+    limbs_mul(t.data(), a, n, b, n);
+    reduce_limbs(dst);
+}
+
+void barrett_reducer::load(uint32_t* dst, big_integer const& a) {
+    fast_vector const am = a.array;
+    size_t an = trimmed_size(am);
+    if (a.sign || an > n || (an == n && limbs_cmp(am.data(), m.data(), n) >= 0)) {
+        big_integer reduced = reduce(a);
+        fast_vector const rm = reduced.array;
+        an = trimmed_size(rm);
+        memcpy(dst, rm.data(), an * sizeof(uint32_t));
+    } else {
+        memcpy(dst, am.data(), an * sizeof(uint32_t));
+    }
+    memset(dst + an, 0, (n - an) * sizeof(uint32_t));
+}
+
+big_integer barrett_reducer::reduce(big_integer const& a) {
+    fast_vector const am = a.magnitude();
+    size_t an = trimmed_size(am);
+    if (an < n || (an == n && limbs_cmp(am.data(), m.data(), n) < 0)) return a.sign ? a + mod : a;
+
+    // the top 2n limbs at most, then n limbs at a time: acc = (acc * B^n + chunk) mod m
+    size_t chunks = (an > 2 * n) ? (an - n - 1) / n : 0;
+    memset(t.data(), 0, 2 * n * sizeof(uint32_t));
+    memcpy(t.data(), am.data() + chunks * n, (an - chunks * n) * sizeof(uint32_t));
+    reduce_limbs(acc.data());
+    for (size_t c = chunks; c > 0; c--) {
+        memcpy(t.data(), am.data() + (c - 1) * n, n * sizeof(uint32_t));
+        memcpy(t.data() + n, acc.data(), n * sizeof(uint32_t));
+        reduce_limbs(acc.data());
+    }
+    big_integer res = big_integer::from_magnitude(false, acc.data(), n);
+    return (a.sign && !res.is_zero()) ? mod - res : res;
+}
+
+big_integer barrett_reducer::mulmod(big_integer const& a, big_integer const& b) {
+    load(x.data(), a);
+    load(y.data(), b);
+    mul_limbs(x.data(), x.data(), y.data());
+    return big_integer::from_magnitude(false, x.data(), n);
+}
+
+big_integer barrett_reducer::sqrmod(big_integer const& a) {
+    load(x.data(), a);
+    mul_limbs(x.data(), x.data(), x.data());
+    return big_integer::from_magnitude(false, x.data(), n);
+}
+
+big_integer barrett_reducer::pow(big_integer const& base, big_integer const& exp) {
+    if (exp.sign) throw runtime_error("negative exponent");
+    fast_vector const e = exp.array;
+    size_t en = trimmed_size(e);
+    if (en == 0) return (mod == 1) ? 0 : 1;
+
+    vector<uint32_t> b(n), res(n);
+    load(b.data(), base);
+    window_pow(n, res.data(), b.data(), e.data(), en, [this](uint32_t* dst, uint32_t const* u, uint32_t const* v) {
+        mul_limbs(dst, u, v);
+    });
+    return big_integer::from_magnitude(false, res.data(), n);
+}
+
+big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& mod) {
+    if (mod.sign || mod.is_zero()) throw runtime_error("modulus must be positive");
+    if (exp.sign) throw runtime_error("negative exponent");
+    if (mod == 1) return 0;
+    if (mod.array[0] & 1) return montgomery_context(mod).pow(base, exp);
+    return barrett_reducer(mod).pow(base, exp);
+}
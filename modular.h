@@ -0,0 +1,77 @@
+#ifndef MODULAR_H
+#define MODULAR_H
+
+#include "big_integer.h"
+#include <cstdint>
+#include <vector>
+
+// Arithmetic modulo a fixed odd m > 1 without division. Residues are kept multiplied by
+// R = 2^(64n), n the count of 64-bit words of m, and a product is brought back by Montgomery
+// reduction, which only needs the precomputed -m^-1 mod 2^64. R^2 mod m is cached to enter
+// that form.
+struct montgomery_context {
+    explicit montgomery_context(big_integer const& m);
+
+    big_integer const& modulus() const;
+    // (a * b) mod m, in [0, m)
+    big_integer mul(big_integer const& a, big_integer const& b) const;
+    // base^exp mod m, in [0, m); exp >= 0
+    big_integer pow(big_integer const& base, big_integer const& exp) const;
+
+    // Residues kept in Montgomery form a R mod m, size() words each, for long chains of
+    // operations without converting in between. Equal residues have equal words.
+    size_t size() const;
+    std::vector<uint64_t> to_montgomery(big_integer const& a) const;
+    big_integer from_montgomery(uint64_t const* x) const;
+    // r = a b R^-1 (the form of the product), with scratch t of size() + 2 words
+    void mul(uint64_t* r, uint64_t const* a, uint64_t const* b, uint64_t* t) const;
+    // r = a + b and r = a - b mod m
+    void add(uint64_t* r, uint64_t const* a, uint64_t const* b) const;
+    void sub(uint64_t* r, uint64_t const* a, uint64_t const* b) const;
+
+private:
+    big_integer mod;
+    size_t n;
+    uint64_t m_inv;
+    std::vector<uint64_t> m;
+    std::vector<uint64_t> r2;
+
+    // a mod m as n words
+    std::vector<uint64_t> residue(big_integer const& a) const;
+};
+
+// Reduction modulo a fixed m > 0 by multiplying with mu = floor((B^2n - 1) / m), B = 2^32
+// and n the limb count of m, instead of dividing (Barrett). Every call works in scratch
+// space owned by the reducer, so only the result is allocated; that also means one reducer
+// must not be used from several threads at once.
+struct barrett_reducer {
+    explicit barrett_reducer(big_integer const& m);
+
+    big_integer const& modulus() const;
+    // a mod m, in [0, m), for any a
+    big_integer reduce(big_integer const& a);
+    // (a * b) mod m and (a * a) mod m, in [0, m)
+    big_integer mulmod(big_integer const& a, big_integer const& b);
+    big_integer sqrmod(big_integer const& a);
+    // base^exp mod m, in [0, m); exp >= 0
+    big_integer pow(big_integer const& base, big_integer const& exp);
+
+private:
+    big_integer mod;
+    size_t n;
+    std::vector<uint32_t> m, mu;
+    std::vector<uint32_t> acc, x, y, t, q, r;
+
+    // dst[0, n) = a mod m
+    void load(uint32_t* dst, big_integer const& a);
+    // dst[0, n) = t[0, 2n) mod m, for t < B^2n
+    void reduce_limbs(uint32_t* dst);
+    // dst[0, n) = a * b mod m, for a, b < m
+    void mul_limbs(uint32_t* dst, uint32_t const* a, uint32_t const* b);
+};
+
+// base^exp mod m for exp >= 0 and m > 0, in [0, m). Odd moduli go through a
+// montgomery_context, even ones through a barrett_reducer.
+big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& m);
+
+#endif
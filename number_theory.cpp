@@ -0,0 +1,1240 @@
+#include "number_theory.h"
+#include "modular.h"
+#include "limb_arith.h"
+#include "limb_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+static size_t bit_length(uint32_t const* a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) n--;
+    if (n == 0) return 0;
+    size_t bits = 32 * n;
+    for (uint32_t top = a[n - 1]; !(top & 0x80000000u); top <<= 1) bits--;
+    return bits;
+}
+
+static size_t bit_length(fast_vector const& a) {
+    return bit_length(a.data(), a.size());
+}
+
+static unsigned trailing_zeros(uint64_t x) {
+    unsigned n = 0;
+    for (; !(x & 1); x >>= 1) n++;
+    return n;
+}
+
+// floor(a / 2^shift) mod 2^64
+static uint64_t bits_from(uint32_t const* a, size_t n, size_t shift) {
+    size_t i = shift / 32;
+    unsigned s = shift % 32;
+    uint64_t lo = 0, hi = 0;
+    if (i < n) lo = a[i];
+    if (i + 1 < n) lo |= uint64_t(a[i + 1]) << 32;
+    if (i + 2 < n) hi = a[i + 2];
+    return (s == 0) ? lo : (lo >> s) | (hi << (64 - s));
+}
+
+static uint64_t bits_from(fast_vector const& a, size_t shift) {
+    return bits_from(a.data(), a.size(), shift);
+}
+
+static uint64_t binary_gcd(uint64_t a, uint64_t b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    unsigned k = trailing_zeros(a | b);
+    a >>= trailing_zeros(a);
+    while (b != 0) {
+        b >>= trailing_zeros(b);
+        if (a > b) swap(a, b);
+        b -= a;
+    }
+    return a << k;
+}
+
+// The Jacobi symbol of a pair x, y >= 0 followed through the steps (x, y) -> (y, x - q y)
+// of Euclid's algorithm, with only q mod 4 per step (Moller's method). The symbol is
+// (-1)^negative (y / x), or (x / y) with den_y, whichever of them has the odd denominator;
+// x and y hold the values mod 4. Reducing the numerator by the denominator keeps the symbol;
+// to reduce an odd denominator x by an odd y the symbol is first turned over by reciprocity,
+// and by an even y the denominator changes from x to x - q y, which for y = 2 (mod 4) flips
+// the sign depending on q and x mod 4 only.
+struct jacobi_state {
+    bool negative, den_y;
+    unsigned x, y;
+
+    jacobi_state(uint32_t x, uint32_t y) : negative(false), den_y(false), x(x & 3), y(y & 3) {}
+
+    void step(uint64_t q) {
+        unsigned qm = static_cast<unsigned>(q & 3), r = (x - qm * y) & 3;
+        if (den_y) {
+            den_y = false;
+        } else if (y & 1) {
+            if (x == 3 && y == 3) negative = !negative;
+        } else {
+            if (y == 2 && ((qm & 1) ? (qm == 3) != (x == 3) : qm == 2)) negative = !negative;
+            den_y = true;
+        }
+        x = y, y = r;
+    }
+
+    // the symbol for the final x, y < 2^64
+    int value(uint64_t xv, uint64_t yv) const;
+};
+
+// Knuth's algorithm L on the leading bits x >= y of two numbers: the cofactors A, B, C, D of
+// every Euclidean quotient that (x + A) / (y + C) == (x + B) / (y + D) proves to be the
+// quotient of the full numbers too. Stops before a cofactor reaches 2^32; B == 0 means not
+// even the first quotient was certain. With least > 0 it also stops before y + min(C, D),
+// the least the next remainder can be, drops below it. The quotients are passed to js.
+static void lehmer_cofactors(uint64_t xh, uint64_t yh, int64_t& A, int64_t& B, int64_t& C, int64_t& D,
+                             jacobi_state* js = nullptr, int64_t least = 0) {
+    int64_t x = static_cast<int64_t>(xh), y = static_cast<int64_t>(yh);
+    A = 1, B = 0, C = 0, D = 1;
+    for (;;) {
+        if (y + C <= 0 || y + D <= 0 || x + A < 0 || x + B < 0) return;
+        int64_t q = (x + A) / (y + C);
+        if (q != (x + B) / (y + D) || q >= (int64_t(1) << 32)) return;
+        uint64_t next_c = uint64_t(A < 0 ? -A : A) + uint64_t(q) * uint64_t(C < 0 ? -C : C);
+        uint64_t next_d = uint64_t(B < 0 ? -B : B) + uint64_t(q) * uint64_t(D < 0 ? -D : D);
+        if (next_c >> 32 || next_d >> 32) return;
+        if (least > 0 && x - q * y + min(A - q * C, B - q * D) < least) return;
+        int64_t t = A - q * C;
+        A = C, C = t;
+        t = B - q * D;
+        B = D, D = t;
+        t = x - q * y;
+        x = y, y = t;
+        if (js != nullptr) js->step(static_cast<uint64_t>(q));
+    }
+}
+
+// A unimodular transform (a, b) = M (a', b') from the current pair back to an earlier one.
+struct gcd_matrix {
+    big_integer m00, m01, m10, m11;
+    int det;
+
+    gcd_matrix() : m00(1), m01(0), m10(0), m11(1), det(1) {}
+
+    // M = M * N
+    void mul(gcd_matrix const& n) {
+        big_integer r00 = m00 * n.m00 + m01 * n.m10, r01 = m00 * n.m01 + m01 * n.m11;
+        big_integer r10 = m10 * n.m00 + m11 * n.m10, r11 = m10 * n.m01 + m11 * n.m11;
+        m00.swap(r00), m01.swap(r01), m10.swap(r10), m11.swap(r11);
+        det *= n.det;
+    }
+};
+
+// One step of Euclid on a >= b > 0: a Lehmer step worth about 31 bits, or a single division
+// when the leading bits cannot settle a quotient. Any transform is recorded in M, and if
+// cofactors u, v are given they are transformed the same way as a, b; the quotients go to js.
+// With min_bits, no quotient is taken that leaves b shorter than that; false if not even one
+// could be.
+static bool euclid_step(big_integer& a, big_integer& b, gcd_matrix* M, big_integer* u = nullptr, big_integer* v = nullptr,
+                        jacobi_state* js = nullptr, size_t min_bits = 0) {
+    fast_vector const am = a.magnitude(), bm = b.magnitude();
+    size_t n = bit_length(am);
+    int64_t A = 1, B = 0, C = 0, D = 1;
+    if (n > 64) {
+        // b' >= 2^(n - 62) (y' + min(C, D)) >= 2^(min_bits - 1)
+        size_t shift = n - 62;
+        int64_t least = 0;
+        if (min_bits > shift + 63) least = numeric_limits<int64_t>::max();
+        else if (min_bits > shift + 1) least = int64_t(1) << (min_bits - shift - 1);
+        else if (min_bits > 0) least = 1;
+        lehmer_cofactors(bits_from(am, shift), bits_from(bm, shift), A, B, C, D, js, least);
+    }
+
+    if (B == 0) {
+        big_integer q = a / b;
+        big_integer r = a - q * b;
+        if (r.bit_length() < min_bits) return false;
+        if (js != nullptr) {
+            fast_vector const qm = q.magnitude();
+            js->step(qm[0]);
+        }
+        a.swap(b);
+        b.swap(r);
+        if (u != nullptr) {
+            r = *u - q * *v;
+            u->swap(*v);
+            v->swap(r);
+        }
+        if (M != nullptr) {
+            // (a, b) = (q b' + a', b'): M = M * [[q, 1], [1, 0]]
+            big_integer t = M->m00 * q + M->m01;
+            M->m01.swap(M->m00);
+            M->m00.swap(t);
+            t = M->m10 * q + M->m11;
+            M->m11.swap(M->m10);
+            M->m10.swap(t);
+            M->det = -M->det;
+        }
+        return true;
+    }
+
+    big_integer fa(A), fb(B), fc(C), fd(D);
+    big_integer na = fa * a + fb * b;
+    big_integer nb = fc * a + fd * b;
+    a.swap(na);
+    b.swap(nb);
+    if (u != nullptr) {
+        na = fa * *u + fb * *v;
+        nb = fc * *u + fd * *v;
+        u->swap(na);
+        v->swap(nb);
+    }
+    if (M != nullptr) {
+        // M = M * L^-1 with L = [[A, B], [C, D]], L^-1 = det(L) [[D, -B], [-C, A]]
+        int det = (D > 0) ? 1 : -1;
+        gcd_matrix inverse;
+        inverse.m00 = det * fd, inverse.m01 = -det * fb;
+        inverse.m10 = -det * fc, inverse.m11 = det * fa;
+        inverse.det = det;
+        M->mul(inverse);
+    }
+    return true;
+}
+
+// Brings a, b back to a >= b >= 0 after an approximate transform, keeping M consistent.
+static void normalize(big_integer& a, big_integer& b, gcd_matrix* M) {
+    if (a.is_negative()) {
+        a = -a;
+        if (M != nullptr) M->m00 = -M->m00, M->m10 = -M->m10, M->det = -M->det;
+    }
+    if (b.is_negative()) {
+        b = -b;
+        if (M != nullptr) M->m01 = -M->m01, M->m11 = -M->m11, M->det = -M->det;
+    }
+    if (a < b) {
+        a.swap(b);
+        if (M != nullptr) M->m00.swap(M->m01), M->m10.swap(M->m11), M->det = -M->det;
+    }
+}
+
+static void hgcd(big_integer& a, big_integer& b, gcd_matrix* M);
+
+// Reduces the bits of (a, b) above k with hgcd and carries the transform over to the full
+// numbers: with (a, b) = 2^k (a1, b1) + (a0, b0), N^-1 (a, b) = 2^k N^-1 (a1, b1) + N^-1 (a0, b0).
+// Only the low part is multiplied, but the result may come out of order and needs normalizing.
+static void reduce_top(big_integer& a, big_integer& b, gcd_matrix* M, size_t k) {
+    big_integer a1 = a >> k, b1 = b >> k;
+    big_integer a0 = a - (a1 << k), b0 = b - (b1 << k);
+    gcd_matrix N;
+    hgcd(a1, b1, &N);
+    big_integer na = (a1 << k) + N.det * (N.m11 * a0 - N.m01 * b0);
+    big_integer nb = (b1 << k) + N.det * (N.m00 * b0 - N.m10 * a0);
+    a.swap(na);
+    b.swap(nb);
+    if (M != nullptr) M->mul(N);
+    normalize(a, b, M);
+}
+
+// Half-gcd: reduces a >= b >= 0 of n bits until b has at most n / 2 bits, multiplying the
+// transform into M if it is given. Above HGCD_THRESHOLD the first half of the work is done
+// recursively on the top n / 2 bits and the second half on the top bits of what is left,
+// so the cost is O(M(n) log n).
+static void hgcd(big_integer& a, big_integer& b, gcd_matrix* M) {
+    size_t n = a.bit_length(), target = n / 2;
+    if (n >= 32 * HGCD_THRESHOLD && b.bit_length() > target) {
+        reduce_top(a, b, M, target);
+        size_t n2 = a.bit_length();
+        if (b.bit_length() > target && 2 * target > n2 && n2 - (2 * target - n2) >= 32 * HGCD_THRESHOLD / 2) {
+            reduce_top(a, b, M, 2 * target - n2);
+        }
+    }
+    while (b.bit_length() > target) euclid_step(a, b, M);
+}
+
+big_integer gcd(big_integer const& a, big_integer const& b) {
+    big_integer x = a.abs(), y = b.abs();
+    if (x.is_zero()) return y;
+    if (y.is_zero()) return x;
+
+    // gcd(2^i x', 2^j y') = 2^min(i, j) gcd(x', y')
+    size_t xz = x.count_trailing_zeros(), yz = y.count_trailing_zeros();
+    x >>= xz;
+    y >>= yz;
+    if (x < y) x.swap(y);
+
+    while (!y.is_zero()) {
+        size_t n = x.bit_length();
+        if (n <= 64) {
+            fast_vector const xm = x.magnitude(), ym = y.magnitude();
+            x = big_integer(binary_gcd(bits_from(xm, 0), bits_from(ym, 0)));
+            break;
+        }
+        if (n >= 32 * GCD_DC_THRESHOLD) hgcd(x, y, nullptr);
+        if (!y.is_zero()) euclid_step(x, y, nullptr);
+    }
+    return x << min(xz, yz);
+}
+
+// (u, v) = N^-1 (u, v), N^-1 = det(N) [[n11, -n01], [-n10, n00]]
+static void apply_inverse(gcd_matrix const& N, big_integer& u, big_integer& v) {
+    big_integer nu = N.det * (N.m11 * u - N.m01 * v);
+    big_integer nv = N.det * (N.m00 * v - N.m10 * u);
+    u.swap(nu);
+    v.swap(nv);
+}
+
+xgcd_result xgcd(big_integer const& a, big_integer const& b) {
+    xgcd_result res;
+    if (b.is_zero()) {
+        res.g = a.abs();
+        res.s = a.is_zero() ? 0 : a.is_negative() ? -1 : 1;
+        res.t = 0;
+        return res;
+    }
+    if (a.is_zero()) {
+        res.g = b.abs();
+        res.s = 0;
+        res.t = b.is_negative() ? -1 : 1;
+        return res;
+    }
+
+    // x = u * first and y = v * first modulo second throughout, so only the cofactors of the
+    // first operand are carried along; every transform of (x, y) is applied to (u, v) as well.
+    big_integer x = a.abs(), y = b.abs();
+    bool swapped = x < y;
+    if (swapped) x.swap(y);
+    big_integer const first = x, second = y;
+    big_integer u = 1, v = 0;
+    while (!y.is_zero()) {
+        if (x.bit_length() >= 32 * GCD_DC_THRESHOLD) {
+            gcd_matrix N;
+            hgcd(x, y, &N);
+            apply_inverse(N, u, v);
+        }
+        if (!y.is_zero()) euclid_step(x, y, nullptr, &u, &v);
+    }
+
+    // x = u * first + w * second exactly; s goes with a and is reduced modulo |b| / g
+    big_integer s = swapped ? (x - u * first) / second : u;
+    if (a.is_negative()) s = -s;
+    big_integer bound = b.abs() / x;
+    s %= bound;
+    if (s.is_negative()) s += bound;
+    res.g = x;
+    res.s = s;
+    res.t = (x - s * a) / b;
+    return res;
+}
+
+big_integer modinv(big_integer const& a, big_integer const& m) {
+    if (m.is_negative() || m.is_zero()) throw runtime_error("modulus must be positive");
+    if (m == 1) return 0;
+    xgcd_result r = xgcd(a, m);
+    if (r.g != 1) throw runtime_error("value is not invertible");
+    return r.s;
+}
+
+vector<big_integer> batch_modinv(vector<big_integer> const& a, big_integer const& m) {
+    if (m.is_negative() || m.is_zero()) throw runtime_error("modulus must be positive");
+    vector<big_integer> res(a.size());
+    if (a.empty() || m == 1) return res;
+
+    // res[i] = a[0] * ... * a[i] mod m, then inv = (a[0] * ... * a[i])^-1 walking back
+    barrett_reducer red(m);
+    res[0] = red.reduce(a[0]);
+    for (size_t i = 1; i < a.size(); i++) res[i] = red.mulmod(res[i - 1], a[i]);
+    big_integer inv = modinv(res.back(), m);
+    for (size_t i = a.size() - 1; i > 0; i--) {
+        res[i] = red.mulmod(inv, res[i - 1]);
+        inv = red.mulmod(inv, a[i]);
+    }
+    res[0] = inv;
+    return res;
+}
+
+// Jacobi symbol (a / n) for odd n > 0
+static int jacobi_64(uint64_t a, uint64_t n) {
+    int res = 1;
+    a %= n;
+    while (a != 0) {
+        unsigned z = trailing_zeros(a);
+        a >>= z;
+        if ((z & 1) && (n % 8 == 3 || n % 8 == 5)) res = -res;
+        if (a % 4 == 3 && n % 4 == 3) res = -res;
+        swap(a, n);
+        a %= n;
+    }
+    return (n == 1) ? res : 0;
+}
+
+int jacobi_state::value(uint64_t xv, uint64_t yv) const {
+    int res = den_y ? jacobi_64(xv, yv) : jacobi_64(yv, xv);
+    return negative ? -res : res;
+}
+
+static void jacobi_hgcd(big_integer& a, big_integer& b, gcd_matrix* M, jacobi_state& js);
+
+// reduce_top for jacobi_hgcd. The transform of the top bits is taken only if it leaves both
+// numbers nonnegative and b at least min_bits long: a product of Euclid steps (a, b) =
+// [[q, 1], [1, 0]] (a', b') with a', b' >= 0 has only nonnegative pairs on the way, so its
+// quotients are good for the symbol of the full numbers. Otherwise nothing changes.
+static void jacobi_reduce_top(big_integer& a, big_integer& b, gcd_matrix* M, size_t k, jacobi_state& js,
+                              size_t min_bits) {
+    big_integer a1 = a >> k, b1 = b >> k;
+    big_integer a0 = a - (a1 << k), b0 = b - (b1 << k);
+    gcd_matrix N;
+    jacobi_state saved = js;
+    jacobi_hgcd(a1, b1, &N, js);
+    big_integer na = (a1 << k) + N.det * (N.m11 * a0 - N.m01 * b0);
+    big_integer nb = (b1 << k) + N.det * (N.m00 * b0 - N.m10 * a0);
+    if (na.is_negative() || nb.is_negative() || nb.bit_length() < min_bits) {
+        js = saved;
+        return;
+    }
+    a.swap(na);
+    b.swap(nb);
+    if (M != nullptr) M->mul(N);
+    if (a < b) {
+        // a step with q = 0
+        a.swap(b);
+        js.step(0);
+        if (M != nullptr) M->m00.swap(M->m01), M->m10.swap(M->m11), M->det = -M->det;
+    }
+}
+
+// hgcd that takes exactly the quotients of Euclid's algorithm, as the symbol needs them:
+// reduces a >= b >= 0 of n bits as long as b keeps more than n / 2 + 1 bits. The top bits
+// of a and b are reduced as far as that keeps the correction from the low bits below what
+// is left (Moller's condition), which leaves the quotients right in all but rare cases
+// that jacobi_reduce_top catches and leaves to single steps. Single steps also bring a down
+// to 3n / 4 bits between the two halves, in case the first could not start because of a
+// large quotient, so that the second half is never more than n / 2 bits long either.
+static void jacobi_hgcd(big_integer& a, big_integer& b, gcd_matrix* M, jacobi_state& js) {
+    size_t n = a.bit_length(), min_bits = n / 2 + 2;
+    if (n >= 32 * HGCD_THRESHOLD && b.bit_length() >= min_bits) {
+        jacobi_reduce_top(a, b, M, n / 2, js, min_bits);
+        while (a.bit_length() > 3 * n / 4 && b.bit_length() >= min_bits &&
+               euclid_step(a, b, M, nullptr, nullptr, &js, min_bits)) {}
+        size_t n2 = a.bit_length();
+        if (b.bit_length() >= min_bits && n2 <= 3 * n / 4 && 2 * (n2 - min_bits) >= 32 * HGCD_THRESHOLD / 2) {
+            jacobi_reduce_top(a, b, M, 2 * min_bits - n2, js, min_bits);
+        }
+    }
+    while (b.bit_length() >= min_bits && euclid_step(a, b, M, nullptr, nullptr, &js, min_bits)) {}
+}
+
+// t = A x + B y >= 0 over n + 1 limbs for cofactors A, B of opposite signs
+static void combine(uint32_t* t, uint32_t const* x, uint32_t const* y, size_t n, int64_t A, int64_t B) {
+    if (B <= 0) {
+        t[n] = limbs_mul_1(t, x, n, static_cast<uint32_t>(A));
+        t[n] -= limbs_submul_1(t, y, n, static_cast<uint32_t>(-B));
+    } else {
+        t[n] = limbs_mul_1(t, y, n, static_cast<uint32_t>(B));
+        t[n] -= limbs_submul_1(t, x, n, static_cast<uint32_t>(-A));
+    }
+}
+
+static size_t trimmed(vector<uint32_t> const& a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) n--;
+    return n;
+}
+
+// The symbol of x > y >= 0 by Lehmer steps applied in place to arrays of limbs, down to 64
+// bits, so that the steps allocate nothing but in the rare single divisions.
+static int jacobi_lehmer(big_integer const& a, big_integer const& b, jacobi_state js) {
+    fast_vector const am = a.magnitude(), bm = b.magnitude();
+    size_t nx = am.size();
+    while (nx > 0 && am[nx - 1] == 0) nx--;
+    vector<uint32_t> x(nx + 1), y(nx + 1), t(nx + 1), u(nx + 1), q(nx + 1);
+    copy(am.data(), am.data() + nx, x.begin());
+    copy(bm.data(), bm.data() + min(nx, bm.size()), y.begin());
+    size_t ny = trimmed(y, nx);
+
+    while (nx > 2) {
+        if (ny == 0) return 0;
+        fill(y.begin() + ny, y.begin() + nx, 0);
+        size_t shift = bit_length(x.data(), nx) - 62;
+        int64_t A, B, C, D;
+        lehmer_cofactors(bits_from(x.data(), nx, shift), bits_from(y.data(), ny, shift), A, B, C, D, &js);
+        if (B == 0) {
+            limbs_divrem(q.data(), t.data(), x.data(), nx, y.data(), ny);
+            js.step(q[0]);
+            x.swap(y);
+            y.swap(t);
+            nx = ny;
+            ny = trimmed(y, ny);
+        } else {
+            combine(t.data(), x.data(), y.data(), nx, A, B);
+            combine(u.data(), x.data(), y.data(), nx, C, D);
+            x.swap(t);
+            y.swap(u);
+            ny = trimmed(y, nx + 1);
+            nx = trimmed(x, nx + 1);
+        }
+    }
+    return js.value(bits_from(x.data(), nx, 0), bits_from(y.data(), ny, 0));
+}
+
+int jacobi(big_integer const& a, big_integer const& n) {
+    if (n.is_negative() || n.is_zero()) throw runtime_error("modulus must be odd and positive");
+    fast_vector const nm = n.magnitude();
+    if (!(nm[0] & 1)) throw runtime_error("modulus must be odd and positive");
+
+    big_integer x = n, y = a % n;
+    if (y.is_negative()) y += n;
+    fast_vector const ym = y.magnitude();
+    jacobi_state js(nm[0], y.is_zero() ? 0 : ym[0]);
+    while (!y.is_zero() && x.bit_length() >= 32 * JACOBI_DC_THRESHOLD) {
+        jacobi_hgcd(x, y, nullptr, js);
+        if (!y.is_zero()) euclid_step(x, y, nullptr, nullptr, nullptr, &js);
+    }
+    return jacobi_lehmer(x, y, js);
+}
+
+int kronecker(big_integer const& a, big_integer const& n) {
+    if (n.is_zero()) return (a == 1 || a == -1) ? 1 : 0;
+    fast_vector const am = a.magnitude();
+    uint32_t low = a.is_zero() ? 0 : am[0];
+    // (a / -1) = sign of a, (a / 2) = 1 for a = +-1 (mod 8) and -1 for a = +-3 (mod 8)
+    int res = (n.is_negative() && a.is_negative()) ? -1 : 1;
+    big_integer m = n.abs();
+    size_t z = m.count_trailing_zeros();
+    if (z > 0) {
+        if (!(low & 1)) return 0;
+        if ((z & 1) && (low % 8 == 3 || low % 8 == 5)) res = -res;
+        m >>= z;
+    }
+    return res * jacobi(a, m);
+}
+
+// floor(sqrt(a)), starting from the double estimate, which is off by a few units at most
+static uint64_t isqrt_64(uint64_t a) {
+    uint64_t s = static_cast<uint64_t>(sqrt(static_cast<double>(a)));
+    if (s > 0xffffffffu) s = 0xffffffffu;
+    while (s * s > a) s--;
+    while (s < 0xffffffffu && (s + 1) * (s + 1) <= a) s++;
+    return s;
+}
+
+// sqrtrem of 2^(w - 2) <= a < 2^w, w even. The low 2l bits, l = w / 4, are split off as
+// a1 2^l + a0; with (s', r') the root of the rest, (r' 2^l + a1) / 2s' is the next l bits
+// of the root, possibly one too large, which shows up as a negative remainder.
+static void sqrtrem_rec(big_integer const& a, size_t w, big_integer& s, big_integer& r) {
+    if (w <= 64) {
+        uint64_t v = bits_from(a.magnitude(), 0), root = isqrt_64(v);
+        s = big_integer(root);
+        r = big_integer(v - root * root);
+        return;
+    }
+    size_t l = w / 4;
+    big_integer high = a >> (2 * l), rest = a - (high << (2 * l));
+    big_integer a1 = rest >> l, a0 = rest - (a1 << l);
+    big_integer s1, r1;
+    sqrtrem_rec(high, w - 2 * l, s1, r1);
+
+    big_integer d = s1 << 1;
+    big_integer num = (r1 << l) + a1;
+    big_integer q = num / d, u = num - q * d;
+    s = (s1 << l) + q;
+    r = (u << l) + a0 - q * q;
+    while (r.is_negative()) {
+        r += (s << 1) - 1;
+        s -= 1;
+    }
+}
+
+sqrtrem_result sqrtrem(big_integer const& a) {
+    if (a.is_negative()) throw runtime_error("square root of a negative number");
+    sqrtrem_result res;
+    size_t bits = a.bit_length();
+    if (bits == 0) return res;
+
+    // scale by 4^t so that the top two bits of an even width are not both zero
+    size_t w = (bits + 1) / 2 * 2, t = 0;
+    if (w > 64) {
+        w = (bits + 3) / 4 * 4;
+        t = (w - bits) / 2;
+    }
+    sqrtrem_rec(a << (2 * t), w, res.s, res.r);
+    if (t != 0) {
+        res.s >>= t;
+        res.r = a - res.s * res.s;
+    }
+    return res;
+}
+
+big_integer isqrt(big_integer const& a) {
+    return sqrtrem(a).s;
+}
+
+// floor(a^(1/k)) for a > 0 and k >= 2
+static big_integer iroot_rec(big_integer const& a, unsigned k) {
+    size_t bits = a.bit_length(), root_bits = (bits + k - 1) / k;
+    if (root_bits <= 40) {
+        // a = top 2^shift with top of 53 bits or less, so log2(a) is good to about 1e-15
+        size_t shift = (bits > 53) ? bits - 53 : 0;
+        double top = static_cast<double>(bits_from(a.magnitude(), shift) & ((uint64_t(1) << 53) - 1));
+        uint64_t x = static_cast<uint64_t>(exp2((log2(top) + static_cast<double>(shift)) / k));
+        while (x > 0 && big_integer(x).pow(k) > a) x--;
+        while (big_integer(x + 1).pow(k) <= a) x++;
+        return big_integer(x);
+    }
+
+    // a < (r + 1)^k 2^(kt), so (r + 1) 2^t is above the root, and with t a little below
+    // half the root bits it is close enough that one Newton step lands on the root or just
+    // above it; Newton's iterates never fall below the root
+    size_t t = root_bits / 2 - 16;
+    big_integer x = (iroot_rec(a >> (k * t), k) + 1) << t;
+    x = (big_integer(uint64_t(k - 1)) * x + a / x.pow(k - 1)) / big_integer(uint64_t(k));
+    while (x.pow(k) > a) x -= 1;
+    return x;
+}
+
+big_integer iroot(big_integer const& a, unsigned k) {
+    if (k == 0) throw runtime_error("zeroth root");
+    if (a.is_negative()) {
+        if (k % 2 == 0) throw runtime_error("even root of a negative number");
+        return -iroot(-a, k);
+    }
+    if (k == 1 || a.is_zero()) return a;
+    if (k == 2) return isqrt(a);
+    if (a.bit_length() <= k) return 1;
+    return iroot_rec(a, k);
+}
+
+// residues[i] is true if i is a square modulo m
+static vector<bool> square_residues(uint32_t m) {
+    vector<bool> residues(m);
+    for (uint64_t i = 0; i < m; i++) residues[i * i % m] = true;
+    return residues;
+}
+
+bool is_perfect_square(big_integer const& a) {
+    if (a.is_negative()) return false;
+    if (a.is_zero()) return true;
+    fast_vector const mag = a.magnitude();
+    static vector<bool> const sq64 = square_residues(64), sq63 = square_residues(63), sq65 = square_residues(65),
+        sq17 = square_residues(17), sq241 = square_residues(241);
+    if (!sq64[mag[0] % 64]) return false;
+
+    // 2^24 - 1 = 63 * 65 * 17 * 241, and B = 2^32 = 2^8 modulo it
+    uint64_t const m = 0xffffff;
+    uint64_t rem = 0;
+    for (size_t i = mag.size(); i > 0; i--) rem = ((rem << 8) + mag[i - 1]) % m;
+    if (!sq63[rem % 63] || !sq65[rem % 65] || !sq17[rem % 17] || !sq241[rem % 241]) return false;
+    return sqrtrem(a).r.is_zero();
+}
+
+// The primes below SMALL_PRIME_BOUND, and their products in runs that fit a limb, so that
+// one pass over a number gives its residues modulo several of them.
+struct small_prime_table {
+    vector<uint32_t> primes;
+    vector<uint32_t> products;
+    vector<size_t> ends;
+
+    small_prime_table() {
+        vector<bool> composite(SMALL_PRIME_BOUND);
+        for (uint32_t p = 2; p < SMALL_PRIME_BOUND; p++) {
+            if (composite[p]) continue;
+            primes.push_back(p);
+            for (uint32_t q = p * p; q < SMALL_PRIME_BOUND; q += p) composite[q] = true;
+        }
+        uint64_t product = 1;
+        for (size_t i = 0; i < primes.size(); i++) {
+            if (product * primes[i] >> 32) {
+                products.push_back(static_cast<uint32_t>(product));
+                ends.push_back(i);
+                product = 1;
+            }
+            product *= primes[i];
+        }
+        products.push_back(static_cast<uint32_t>(product));
+        ends.push_back(primes.size());
+    }
+};
+
+static small_prime_table const& small_primes() {
+    static small_prime_table const table;
+    return table;
+}
+
+static uint32_t mod_small(fast_vector const& a, uint32_t d) {
+    uint64_t rem = 0;
+    for (size_t i = a.size(); i > 0; i--) rem = ((rem << 32) | a[i - 1]) % d;
+    return static_cast<uint32_t>(rem);
+}
+
+// (d / n) for odd d and odd n > 0, by reciprocity down to (n mod |d| / |d|)
+static int jacobi_small(int64_t d, big_integer const& n) {
+    fast_vector const mag = n.magnitude();
+    uint64_t ad = static_cast<uint64_t>(d < 0 ? -d : d);
+    int res = jacobi_64(mod_small(mag, static_cast<uint32_t>(ad)), ad);
+    if (ad % 4 == 3 && mag[0] % 4 == 3) res = -res;
+    if (d < 0 && mag[0] % 4 == 3) res = -res;
+    return res;
+}
+
+// base^d 2^r for r < s runs into -1, or base^d = 1, where n - 1 = d 2^s, d odd
+static bool strong_fermat(montgomery_context const& ctx, big_integer const& n, big_integer const& base,
+                          big_integer const& d, size_t s) {
+    size_t w = ctx.size();
+    vector<uint64_t> one = ctx.to_montgomery(1), minus_one = ctx.to_montgomery(n - 1), t(w + 2);
+    vector<uint64_t> y = ctx.to_montgomery(ctx.pow(base, d));
+    if (y == one || y == minus_one) return true;
+    for (size_t r = 1; r < s; r++) {
+        ctx.mul(y.data(), y.data(), y.data(), t.data());
+        if (y == minus_one) return true;
+        if (y == one) return false;
+    }
+    return false;
+}
+
+// The strong Lucas test with P = 1 and Q = (1 - D) / 4: U_d = 0 or V_(d 2^r) = 0 for some
+// r < s, where n + 1 = d 2^s. Only V is computed, by the ladder V_2k = V_k^2 - 2 Q^k,
+// V_(2k+1) = V_k V_(k+1) - P Q^k, and U_d = 0 is read off 2 V_(d+1) - P V_d = D U_d.
+static bool strong_lucas(montgomery_context const& ctx, big_integer const& n, int64_t D) {
+    size_t w = ctx.size();
+    big_integer d = n + 1;
+    size_t s = d.count_trailing_zeros();
+    d >>= s;
+    fast_vector const dm = d.magnitude();
+
+    vector<uint64_t> q = ctx.to_montgomery(big_integer((1 - D) / 4));
+    vector<uint64_t> v0 = ctx.to_montgomery(2), v1 = ctx.to_montgomery(1), qk = ctx.to_montgomery(1);
+    vector<uint64_t> x(w), t(w + 2);
+    for (size_t i = bit_length(dm); i > 0; i--) {
+        // x = V_(2k+1)
+        ctx.mul(x.data(), v0.data(), v1.data(), t.data());
+        ctx.sub(x.data(), x.data(), qk.data());
+        if ((dm[(i - 1) / 32] >> ((i - 1) % 32)) & 1) {
+            // k -> 2k + 1: V_(2k+2) = V_(k+1)^2 - 2 Q^(k+1), Q^(2k+1) = Q^k Q^(k+1)
+            v0.swap(x);
+            ctx.mul(x.data(), qk.data(), q.data(), t.data());
+            ctx.mul(qk.data(), qk.data(), x.data(), t.data());
+            ctx.mul(v1.data(), v1.data(), v1.data(), t.data());
+            ctx.sub(v1.data(), v1.data(), x.data());
+            ctx.sub(v1.data(), v1.data(), x.data());
+        } else {
+            // k -> 2k: V_2k = V_k^2 - 2 Q^k
+            v1.swap(x);
+            ctx.mul(v0.data(), v0.data(), v0.data(), t.data());
+            ctx.sub(v0.data(), v0.data(), qk.data());
+            ctx.sub(v0.data(), v0.data(), qk.data());
+            ctx.mul(qk.data(), qk.data(), qk.data(), t.data());
+        }
+    }
+
+    ctx.add(x.data(), v1.data(), v1.data());
+    if (x == v0) return true;
+    vector<uint64_t> zero(w, 0);
+    for (size_t r = 0; r < s; r++) {
+        if (v0 == zero) return true;
+        ctx.mul(v0.data(), v0.data(), v0.data(), t.data());
+        ctx.sub(v0.data(), v0.data(), qk.data());
+        ctx.sub(v0.data(), v0.data(), qk.data());
+        ctx.mul(qk.data(), qk.data(), qk.data(), t.data());
+    }
+    return false;
+}
+
+bool is_probable_prime(big_integer const& n, unsigned rounds) {
+    if (n.is_negative()) return false;
+    fast_vector const mag = n.magnitude();
+    size_t bits = bit_length(mag);
+    if (bits < 2) return false;
+
+    small_prime_table const& table = small_primes();
+    uint64_t value = bits_from(mag, 0);
+    if (bits <= 32 && value < SMALL_PRIME_BOUND)
+        return binary_search(table.primes.begin(), table.primes.end(), static_cast<uint32_t>(value));
+    for (size_t g = 0, i = 0; g < table.products.size(); g++) {
+        uint32_t rem = mod_small(mag, table.products[g]);
+        for (; i < table.ends[g]; i++) {
+            if (rem % table.primes[i] == 0) return false;
+        }
+    }
+    if (bits <= 32 && value < uint64_t(SMALL_PRIME_BOUND) * SMALL_PRIME_BOUND) return true;
+
+    montgomery_context ctx(n);
+    big_integer n1 = n - 1;
+    size_t s = n1.count_trailing_zeros();
+    big_integer d = n1 >> s;
+    if (!strong_fermat(ctx, n, 2, d, s)) return false;
+
+    // Selfridge: the first of 5, -7, 9, -11, ... with (D / n) = -1, which never comes for squares
+    int64_t D = 5;
+    for (;;) {
+        int j = jacobi_small(D, n);
+        if (j == -1) break;
+        if (j == 0) return false;
+        if (D == 13 && is_perfect_square(n)) return false;
+        D = (D > 0) ? -(D + 2) : -(D - 2);
+    }
+    if (!strong_lucas(ctx, n, D)) return false;
+
+    mt19937_64 rng(0x9e3779b97f4a7c15ull);
+    big_integer range = n - 3;
+    for (unsigned r = 0; r < rounds; r++) {
+        vector<uint32_t> limbs(mag.size() + 1);
+        for (size_t i = 0; i < limbs.size(); i++) limbs[i] = static_cast<uint32_t>(rng());
+        big_integer base = big_integer::from_magnitude(false, limbs.data(), limbs.size()) % range + 2;
+        if (!strong_fermat(ctx, n, base, d, s)) return false;
+    }
+    return true;
+}
+
+prime_sieve::prime_sieve(big_integer const& lo) : bounded(false) {
+    init(lo);
+}
+
+prime_sieve::prime_sieve(big_integer const& lo, big_integer const& hi) : hi(hi), bounded(true) {
+    init(lo);
+}
+
+void prime_sieve::init(big_integer const& lo) {
+    two = lo <= 2 && (!bounded || hi > 2);
+    base = (lo < 3) ? big_integer(3) : lo;
+    fast_vector const bm = base.magnitude();
+    if (!(bm[0] & 1)) base += 1;
+
+    fast_vector const mag = base.magnitude();
+    size_t bits = bit_length(mag);
+    uint32_t bound = static_cast<uint32_t>(min<uint64_t>(SIEVE_PRIME_BOUND, max<uint64_t>(SMALL_PRIME_BOUND, uint64_t(bits) * bits / 8)));
+    vector<uint8_t> sieve(bound);
+    for (uint32_t p = 3; p < bound; p += 2) {
+        if (sieve[p]) continue;
+        primes.push_back(p);
+        for (uint64_t q = uint64_t(p) * p; q < bound; q += 2 * p) sieve[q] = 1;
+    }
+
+    // one pass over base per run of primes whose product fits a limb
+    residues.resize(primes.size());
+    for (size_t i = 0; i < primes.size();) {
+        size_t end = i;
+        uint64_t product = 1;
+        while (end < primes.size() && !(product * primes[end] >> 32)) product *= primes[end++];
+        uint32_t rem = mod_small(mag, static_cast<uint32_t>(product));
+        for (; i < end; i++) residues[i] = rem % primes[i];
+    }
+    composite.resize(SIEVE_SEGMENT);
+    sieve_segment();
+}
+
+void prime_sieve::sieve_segment() {
+    pos = 0;
+    limit = SIEVE_SEGMENT;
+    if (bounded) {
+        big_integer left = (hi - base + 1) >> 1;
+        if (left < big_integer(uint64_t(limit))) limit = left.is_negative() ? 0 : static_cast<size_t>(bits_from(left.magnitude(), 0));
+    }
+
+    // base itself may be a sieving prime, and must not be struck out as its own multiple
+    fast_vector const mag = base.magnitude();
+    bool small = bit_length(mag) <= 32;
+    uint64_t start = bits_from(mag, 0);
+    fill(composite.begin(), composite.end(), 0);
+    for (size_t i = 0; i < primes.size(); i++) {
+        uint64_t p = primes[i];
+        // base + 2j = 0 (mod p) for j = -base / 2
+        uint64_t j = (p - residues[i]) % p * ((p + 1) / 2) % p;
+        if (small && start + 2 * j == p) j += p;
+        for (; j < limit; j += p) composite[j] = 1;
+    }
+}
+
+bool prime_sieve::next(big_integer& p) {
+    if (two) {
+        two = false;
+        p = 2;
+        return true;
+    }
+    for (;;) {
+        for (; pos < limit; pos++) {
+            if (composite[pos]) continue;
+            big_integer candidate = base + big_integer(uint64_t(2 * pos));
+            if (is_probable_prime(candidate)) {
+                pos++;
+                p.swap(candidate);
+                return true;
+            }
+        }
+        if (limit < SIEVE_SEGMENT) return false;
+
+        base += big_integer(uint64_t(2 * SIEVE_SEGMENT));
+        for (size_t i = 0; i < primes.size(); i++)
+            residues[i] = static_cast<uint32_t>((residues[i] + 2 * SIEVE_SEGMENT) % primes[i]);
+        sieve_segment();
+    }
+}
+
+big_integer next_prime(big_integer const& x) {
+    big_integer p;
+    prime_sieve(x + 1).next(p);
+    return p;
+}
+
+static vector<uint32_t> primes_up_to(uint32_t n) {
+    vector<uint32_t> primes;
+    if (n < 2) return primes;
+    primes.push_back(2);
+    vector<bool> composite(n / 2 + 1);
+    for (uint64_t p = 3; p <= n; p += 2) {
+        if (composite[p / 2]) continue;
+        primes.push_back(static_cast<uint32_t>(p));
+        for (uint64_t q = p * p; q <= n; q += 2 * p) composite[q / 2] = true;
+    }
+    return primes;
+}
+
+static uint64_t pow_64(uint64_t x, uint64_t e) {
+    uint64_t res = 1;
+    for (; e != 0; e >>= 1, x *= x) {
+        if (e & 1) res *= x;
+    }
+    return res;
+}
+
+static uint64_t powmod_32(uint64_t x, uint64_t e, uint32_t m) {
+    uint64_t res = 1 % m;
+    for (x %= m; e != 0; e >>= 1, x = x * x % m) {
+        if (e & 1) res = res * x % m;
+    }
+    return res;
+}
+
+// x^(1/p) mod 2^64 for odd x and odd p. Newton's iteration y <- y + y (1 - x y^p) / p for
+// the inverse root doubles the number of right low bits from y = 1, and x y^(p - 1) is the
+// root; x -> x^p is one to one on odd residues, so it is the only one.
+static uint64_t root_mod_2_64(uint64_t x, uint32_t p) {
+    uint64_t inverse = p, y = 1;
+    for (int i = 0; i < 5; i++) inverse *= 2 - p * inverse;
+    for (int i = 0; i < 6; i++) y += y * (1 - x * pow_64(y, p)) * inverse;
+    return x * pow_64(y, p - 1);
+}
+
+// y^e mod 2^k
+static big_integer pow_mod_2k(big_integer const& y, uint64_t e, big_integer const& mask) {
+    big_integer res = 1, x = y;
+    for (; e != 0; e >>= 1) {
+        if (e & 1) res = res * x & mask;
+        if (e > 1) x = x * x & mask;
+    }
+    return res;
+}
+
+// x^(1/p) mod 2^b for odd x, odd p and b > 64: the same iteration, continued from 64 bits
+// with the precision doubled at each step up to b
+static big_integer root_mod_2k(big_integer const& x, uint32_t p, size_t b) {
+    vector<size_t> precisions;
+    for (size_t k = b; k > 64; k = (k + 1) / 2) precisions.push_back(k);
+    fast_vector const xm = x.magnitude();
+    uint64_t x64 = bits_from(xm, 0), inverse64 = p;
+    for (int i = 0; i < 5; i++) inverse64 *= 2 - p * inverse64;
+    uint64_t y64 = 1;
+    for (int i = 0; i < 6; i++) y64 += y64 * (1 - x64 * pow_64(y64, p)) * inverse64;
+
+    big_integer y(y64), inverse(inverse64), mask;
+    for (size_t i = precisions.size(); i > 0; i--) {
+        mask = (big_integer(1) << precisions[i - 1]) - 1;
+        inverse = inverse * ((2 - big_integer(p) * inverse) & mask) & mask;
+        big_integer e = (1 - (x & mask) * pow_mod_2k(y, p, mask)) & mask;
+        y = (y + (y * e & mask) * inverse) & mask;
+    }
+    return (x & mask) * pow_mod_2k(y, p - 1, mask) & mask;
+}
+
+bool is_perfect_power(big_integer const& a) {
+    big_integer u = a.abs();
+    if (u <= 1) return true;
+    bool negative = a.is_negative();
+
+    // a = +-2^z q_1^e_1 ... u with u free of primes below SMALL_PRIME_BOUND: a p-th power
+    // needs p to divide g = gcd(z, e_1, ...), and u to be one
+    size_t z = u.count_trailing_zeros();
+    u >>= z;
+    uint64_t g = z;
+    small_prime_table const& table = small_primes();
+    for (size_t i = 0, begin = 0; i < table.products.size() && u != 1; begin = table.ends[i++]) {
+        uint32_t rem = mod_small(u.magnitude(), table.products[i]);
+        for (size_t j = begin; j < table.ends[i]; j++) {
+            uint32_t q = table.primes[j];
+            if (q == 2 || rem % q != 0) continue;
+            uint64_t e = 0;
+            big_integer bq(q);
+            for (; (u % bq).is_zero(); e++) u /= bq;
+            g = binary_gcd(g, e);
+            if (g == 1) return false;
+        }
+    }
+    if (negative) {
+        // only odd powers
+        while (g != 0 && g % 2 == 0) g /= 2;
+        if (g == 1) return false;
+    }
+    if (u == 1) return g >= 2;
+
+    // a root of u is above SMALL_PRIME_BOUND > 2^10, so p <= bits / 10; for odd p the root
+    // mod 2^b with b above its length is the root itself when there is one, and a wrong
+    // one mostly has the wrong length or residues modulo two primes, before any power is taken
+    size_t n = u.bit_length();
+    fast_vector const um = u.magnitude();
+    uint32_t const q1 = 4294967291u, q2 = 4294967279u;
+    uint32_t u1 = mod_small(um, q1), u2 = mod_small(um, q2);
+    vector<uint32_t> const primes = primes_up_to(static_cast<uint32_t>(min<size_t>(n / 10, UINT32_MAX)));
+    for (size_t i = 0; i < primes.size(); i++) {
+        uint32_t p = primes[i];
+        if (g != 0 && g % p != 0) continue;
+        if (p == 2) {
+            if (!negative && is_perfect_square(u)) return true;
+            continue;
+        }
+        size_t b = n / p + 1;
+        big_integer r = (b <= 64) ? big_integer(root_mod_2_64(bits_from(um, 0), p) & (~uint64_t(0) >> (64 - b)))
+                                  : root_mod_2k(u, p, b);
+        size_t rb = r.bit_length();
+        if (rb < (n - 1) / p + 1 || rb > (n + p - 1) / p) continue;
+        fast_vector const rm = r.magnitude();
+        if (powmod_32(mod_small(rm, q1), p, q1) != u1 || powmod_32(mod_small(rm, q2), p, q2) != u2) continue;
+        if (r.pow(p) == u) return true;
+    }
+    return false;
+}
+
+// log2(a) for a > 0 from its top 53 bits
+static double log2_estimate(big_integer const& a) {
+    size_t bits = a.bit_length(), shift = (bits > 53) ? bits - 53 : 0;
+    fast_vector const mag = a.magnitude();
+    return log2(static_cast<double>(bits_from(mag, shift))) + static_cast<double>(shift);
+}
+
+size_t ilog(big_integer const& a, big_integer const& base) {
+    if (a.is_negative() || a.is_zero()) throw runtime_error("logarithm of a non-positive number");
+    if (base < 2) throw runtime_error("logarithm base must be at least 2");
+    size_t base_bits = base.bit_length();
+    if (base.count_trailing_zeros() == base_bits - 1) return a.ilog2() / (base_bits - 1);
+
+    // the estimate is off by one at most
+    size_t e = static_cast<size_t>(log2_estimate(a) / log2_estimate(base));
+    big_integer p = base.pow(e);
+    for (; p > a; e--) p /= base;
+    for (p *= base; p <= a; e++) p *= base;
+    return e;
+}
+
+// f[lo] * ... * f[hi - 1], split in halves so that the big multiplications are balanced
+static big_integer product(vector<uint64_t> const& f, size_t lo, size_t hi) {
+    if (hi - lo <= 8) {
+        big_integer res = 1;
+        uint64_t acc = 1;
+        for (size_t i = lo; i < hi; i++) {
+            if (f[i] != 0 && acc > UINT64_MAX / f[i]) {
+                res *= big_integer(acc);
+                acc = 1;
+            }
+            acc *= f[i];
+        }
+        return res * big_integer(acc);
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    return product(f, lo, mid) * product(f, mid, hi);
+}
+
+// prod p^e(p) over the primes p with exponent e(p), as ((P_top^2 P_(top-1))^2 ...) P_0 where
+// P_j is the product of the primes with bit j of their exponent set
+static big_integer power_product(vector<uint32_t> const& primes, vector<uint64_t> const& exponents) {
+    uint64_t all = 0;
+    for (size_t i = 0; i < exponents.size(); i++) all |= exponents[i];
+    big_integer res = 1;
+    bool started = false;
+    for (int j = 63; j >= 0; j--) {
+        if (started) res = res * res;
+        if (!((all >> j) & 1)) continue;
+        started = true;
+        vector<uint64_t> f;
+        for (size_t i = 0; i < primes.size(); i++) {
+            if ((exponents[i] >> j) & 1) f.push_back(primes[i]);
+        }
+        res *= product(f, 0, f.size());
+    }
+    return res;
+}
+
+// the exponent of p in n!, by Legendre
+static uint64_t factorial_exponent(uint64_t n, uint64_t p) {
+    uint64_t e = 0;
+    for (; n >= p; n /= p) e += n / p;
+    return e;
+}
+
+static uint32_t small_argument(uint64_t n) {
+    if (n > UINT32_MAX) throw runtime_error("argument is too large");
+    return static_cast<uint32_t>(n);
+}
+
+big_integer factorial(uint64_t n) {
+    vector<uint32_t> primes = primes_up_to(small_argument(n));
+    if (primes.empty()) return 1;
+    // the power of two becomes a shift
+    vector<uint64_t> exponents(primes.size());
+    for (size_t i = 1; i < primes.size(); i++) exponents[i] = factorial_exponent(n, primes[i]);
+    return power_product(primes, exponents) << factorial_exponent(n, 2);
+}
+
+big_integer double_factorial(uint64_t n) {
+    small_argument(n);
+    // (2m)!! = 2^m m!, and (2m + 1)!! = (2m + 1)! / (2^m m!)
+    uint64_t m = n / 2;
+    if (n % 2 == 0) return factorial(m) << m;
+    vector<uint32_t> primes = primes_up_to(static_cast<uint32_t>(n));
+    vector<uint64_t> exponents(primes.size());
+    for (size_t i = 1; i < primes.size(); i++) exponents[i] = factorial_exponent(n, primes[i]) - factorial_exponent(m, primes[i]);
+    return power_product(primes, exponents);
+}
+
+big_integer binomial(uint64_t n, uint64_t k) {
+    if (k > n) return 0;
+    k = min(k, n - k);
+    if (k == 0) return 1;
+    if (n <= UINT32_MAX) {
+        // Kummer: the exponent of p is the number of borrows in n - k in base p
+        vector<uint32_t> primes = primes_up_to(static_cast<uint32_t>(n));
+        vector<uint64_t> exponents(primes.size());
+        for (size_t i = 0; i < primes.size(); i++) {
+            uint64_t p = primes[i];
+            exponents[i] = factorial_exponent(n, p) - factorial_exponent(k, p) - factorial_exponent(n - k, p);
+        }
+        return power_product(primes, exponents);
+    }
+    // (n - k + 1) ... n / k!, for a k small enough to list the factors
+    small_argument(k);
+    vector<uint64_t> f(k);
+    for (uint64_t i = 0; i < k; i++) f[i] = n - i;
+    return product(f, 0, f.size()) / factorial(k);
+}
+
+big_integer primorial(uint64_t n) {
+    vector<uint32_t> primes = primes_up_to(small_argument(n));
+    vector<uint64_t> f(primes.begin(), primes.end());
+    return product(f, 0, f.size());
+}
+
+// (F_n, F_(n-1)) for n >= 1
+static void fibonacci_pair(uint64_t n, big_integer& f, big_integer& g) {
+    f = 1;
+    g = 0;
+    int top = 63;
+    while (!((n >> top) & 1)) top--;
+    bool odd = true;
+    for (int i = top - 1; i >= 0; i--) {
+        big_integer f2 = f * f, g2 = g * g;
+        // F_(2k+1) and F_(2k-1), with F_2k their difference
+        big_integer next = (f2 << 2) - g2 + (odd ? -2 : 2);
+        big_integer prev = f2 + g2;
+        if ((n >> i) & 1) {
+            g = next - prev;
+            f.swap(next);
+            odd = true;
+        } else {
+            f = next - prev;
+            g.swap(prev);
+            odd = false;
+        }
+    }
+}
+
+big_integer fibonacci(uint64_t n) {
+    if (n == 0) return 0;
+    big_integer f, g;
+    fibonacci_pair(n, f, g);
+    return f;
+}
+
+big_integer lucas(uint64_t n) {
+    if (n == 0) return 2;
+    big_integer f, g;
+    fibonacci_pair(n, f, g);
+    // L_n = F_n + 2 F_(n-1)
+    return f + (g << 1);
+}
+
+// Residues for lucas_ladder in Montgomery form.
+struct montgomery_ring {
+    typedef vector<uint64_t> value;
+
+    montgomery_context ctx;
+    vector<uint64_t> t;
+
+    explicit montgomery_ring(big_integer const& m) : ctx(m), t(ctx.size() + 2) {}
+    value from(big_integer const& a) { return ctx.to_montgomery(a); }
+    big_integer to(value const& a) { return ctx.from_montgomery(a.data()); }
+    void mul(value& r, value const& a, value const& b) { ctx.mul(r.data(), a.data(), b.data(), t.data()); }
+    void add(value& r, value const& a, value const& b) { ctx.add(r.data(), a.data(), b.data()); }
+    void sub(value& r, value const& a, value const& b) { ctx.sub(r.data(), a.data(), b.data()); }
+};
+
+// Residues for lucas_ladder as plain values in [0, m).
+struct barrett_ring {
+    typedef big_integer value;
+
+    barrett_reducer red;
+
+    explicit barrett_ring(big_integer const& m) : red(m) {}
+    value from(big_integer const& a) { return red.reduce(a); }
+    big_integer to(value const& a) { return a; }
+    void mul(value& r, value const& a, value const& b) { r = (&a == &b) ? red.sqrmod(a) : red.mulmod(a, b); }
+    void add(value& r, value const& a, value const& b) {
+        r = a + b;
+        if (r >= red.modulus()) r -= red.modulus();
+    }
+    void sub(value& r, value const& a, value const& b) {
+        r = a - b;
+        if (r.is_negative()) r += red.modulus();
+    }
+};
+
+// From (U_k, U_(k+1)) = (a, b): U_2k = 2ab - P a^2, U_(2k+1) = b^2 - Q a^2, and
+// U_(2k+2) = P U_(2k+1) - Q U_2k; at the end V_k = 2 U_(k+1) - P U_k.
+template<typename Ring>
+static lucas_sequence_result lucas_ladder(Ring& ring, big_integer const& P, big_integer const& Q, fast_vector const& k) {
+    typename Ring::value p = ring.from(P), q = ring.from(Q), a = ring.from(0), b = ring.from(1);
+    typename Ring::value a2 = a, b2 = a, ab = a, x = a;
+    for (size_t i = bit_length(k); i > 0; i--) {
+        ring.mul(a2, a, a);
+        ring.mul(b2, b, b);
+        ring.mul(ab, a, b);
+        // a = U_2k, b = U_(2k+1)
+        ring.add(ab, ab, ab);
+        ring.mul(x, p, a2);
+        ring.sub(a, ab, x);
+        ring.mul(x, q, a2);
+        ring.sub(b, b2, x);
+        if ((k[(i - 1) / 32] >> ((i - 1) % 32)) & 1) {
+            ring.mul(x, q, a);
+            ring.mul(a2, p, b);
+            a.swap(b);
+            ring.sub(b, a2, x);
+        }
+    }
+    lucas_sequence_result res;
+    res.u = ring.to(a);
+    ring.add(b, b, b);
+    ring.mul(x, p, a);
+    ring.sub(b, b, x);
+    res.v = ring.to(b);
+    return res;
+}
+
+lucas_sequence_result lucas_sequence(big_integer const& P, big_integer const& Q, big_integer const& k,
+                                     big_integer const& m) {
+    if (m.is_negative() || m.is_zero()) throw runtime_error("modulus must be positive");
+    if (k.is_negative()) throw runtime_error("negative index");
+    lucas_sequence_result res;
+    if (m == 1) return res;
+    fast_vector const km = k.magnitude(), mm = m.magnitude();
+    if (mm[0] & 1) {
+        montgomery_ring ring(m);
+        return lucas_ladder(ring, P, Q, km);
+    }
+    barrett_ring ring(m);
+    return lucas_ladder(ring, P, Q, km);
+}
@@ -0,0 +1,136 @@
+#ifndef NUMBER_THEORY_H
+#define NUMBER_THEORY_H
+
+#include "big_integer.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// From GCD_DC_THRESHOLD limbs on, gcd halves its operands with the recursive half-gcd;
+// below it, it takes Lehmer steps of about 31 bits each. The half-gcd itself recurses down
+// to HGCD_THRESHOLD limbs.
+const size_t GCD_DC_THRESHOLD = 800;
+const size_t HGCD_THRESHOLD = 60;
+// jacobi goes over to its half-gcd from this many limbs on; its Lehmer steps are done in
+// place, which keeps them ahead longer than those of gcd.
+const size_t JACOBI_DC_THRESHOLD = 5000;
+// is_probable_prime trial-divides by the primes below this.
+const uint32_t SMALL_PRIME_BOUND = 1024;
+// prime_sieve sieves by the primes below about bits^2 / 8 for numbers of that many bits,
+// but by no more than the primes below SIEVE_PRIME_BOUND, SIEVE_SEGMENT odd numbers at a time.
+const uint32_t SIEVE_PRIME_BOUND = 1 << 20;
+const size_t SIEVE_SEGMENT = 1 << 15;
+
+// Greatest common divisor of |a| and |b|, with gcd(0, 0) = 0.
+big_integer gcd(big_integer const& a, big_integer const& b);
+
+struct xgcd_result {
+    big_integer g, s, t;
+};
+
+// g = gcd(a, b) with Bezout coefficients s * a + t * b = g. If b != 0, s is reduced to
+// 0 <= s < |b| / g; xgcd(a, 0) = (|a|, sign of a, 0).
+xgcd_result xgcd(big_integer const& a, big_integer const& b);
+
+// x in [0, m) with a * x = 1 (mod m), for m > 0; throws if gcd(a, m) != 1.
+big_integer modinv(big_integer const& a, big_integer const& m);
+
+// Inverses of every a[i] modulo m > 0 with a single modinv (Montgomery's trick): the prefix
+// products are inverted once and peeled off one by one for 3 (k - 1) multiplications mod m.
+// Throws if some a[i] is not invertible.
+std::vector<big_integer> batch_modinv(std::vector<big_integer> const& a, big_integer const& m);
+
+// The Jacobi symbol (a / n) for odd n > 0, which throws otherwise, and the Kronecker symbol
+// (a / n) for any n. The symbol is followed through the quotients of Euclid's algorithm on
+// (n, a mod n), two bits of state per step: Lehmer steps done in place on the limbs, and
+// from JACOBI_DC_THRESHOLD limbs on a half-gcd that keeps to the exact quotient sequence,
+// for O(M(n) log n).
+int jacobi(big_integer const& a, big_integer const& n);
+int kronecker(big_integer const& a, big_integer const& n);
+
+struct sqrtrem_result {
+    big_integer s, r;
+};
+
+// s = floor(sqrt(a)) and r = a - s^2 for a >= 0, by Zimmermann's Karatsuba square root: the
+// root of the top half gives the top half of the root, and one division by twice that
+// gives the rest. Throws for a < 0.
+sqrtrem_result sqrtrem(big_integer const& a);
+big_integer isqrt(big_integer const& a);
+
+// floor(a^(1/k)) for k > 0, rounded towards zero for a < 0 and odd k. Newton iteration from
+// the root of the top bits, computed the same way, so that one or two steps at the full
+// size are enough. Throws for k == 0 or a < 0 with even k.
+big_integer iroot(big_integer const& a, unsigned k);
+
+// Rejects most non-squares by their residues mod 64 and 2^24 - 1 before taking the root.
+bool is_perfect_square(big_integer const& a);
+
+// Whether a = b^k for some integer b and k >= 2; 0, 1 and -1 count. The exponents of 2 and
+// of the primes below SMALL_PRIME_BOUND must share a factor with k, which settles most
+// numbers; for the rest, every prime k is tried with the 2-adic k-th root computed by
+// Newton's iteration on bits / k bits, and only a root that passes a length and a
+// residue check is raised to the k-th power.
+bool is_perfect_power(big_integer const& a);
+
+// floor(log_base(a)) for a > 0 and base >= 2, throws otherwise: estimated from the leading
+// bits, then base^e is computed once and corrected by a step. Powers of two take ilog2.
+size_t ilog(big_integer const& a, big_integer const& base);
+
+// Baillie-PSW: trial division, a strong Fermat test to base 2 and a strong Lucas test with
+// Selfridge's parameters, all on residues in Montgomery form; no composite is known to pass.
+// rounds adds as many Miller-Rabin tests to pseudo-random bases. Values below 2 are not prime.
+bool is_probable_prime(big_integer const& n, unsigned rounds = 0);
+
+// Probable primes in increasing order from lo on, up to hi if it is given. The odd numbers
+// are sieved a segment at a time: the residues of the segment start modulo the sieving primes
+// are computed once and then advanced by the segment length, so that only the survivors go
+// through is_probable_prime.
+struct prime_sieve {
+    explicit prime_sieve(big_integer const& lo);
+    prime_sieve(big_integer const& lo, big_integer const& hi);
+
+    // the next probable prime of the range, or false at its end
+    bool next(big_integer& p);
+
+private:
+    big_integer base, hi;
+    bool bounded, two;
+    std::vector<uint32_t> primes, residues;
+    std::vector<uint8_t> composite;
+    size_t pos, limit;
+
+    void init(big_integer const& lo);
+    // marks the multiples of the sieving primes among base, base + 2, ... and sets limit
+    void sieve_segment();
+};
+
+// The least probable prime greater than x.
+big_integer next_prime(big_integer const& x);
+
+// n!, n!!, the binomial coefficient (n over k) and the product of the primes p <= n. All of
+// them are put together from their factorizations over the primes up to n, as products of
+// powers p^e taken bit by bit of e and multiplied in balanced trees, so the work is a few
+// large multiplications. binomial is 0 for k > n; n is limited to 32 bits except in binomial
+// with a min(k, n - k) that small, and larger arguments throw.
+big_integer factorial(uint64_t n);
+big_integer double_factorial(uint64_t n);
+big_integer binomial(uint64_t n, uint64_t k);
+big_integer primorial(uint64_t n);
+
+// The Fibonacci and Lucas numbers F_n and L_n, by doubling with two squarings per bit of n:
+// F_(2k+1) = 4 F_k^2 - F_(k-1)^2 + 2 (-1)^k and F_(2k-1) = F_k^2 + F_(k-1)^2.
+big_integer fibonacci(uint64_t n);
+big_integer lucas(uint64_t n);
+
+struct lucas_sequence_result {
+    big_integer u, v;
+};
+
+// U_k and V_k mod m, in [0, m), of the Lucas sequences with parameters P and Q, for k >= 0
+// and m > 0. The pair (U_k, U_(k+1)) is doubled without divisions, so any modulus works;
+// odd moduli are worked in a montgomery_context and even ones through a barrett_reducer.
+lucas_sequence_result lucas_sequence(big_integer const& P, big_integer const& Q, big_integer const& k,
+                                     big_integer const& m);
+
+#endif
@@ -1,4 +1,5 @@
 #include "optimized_vector.h"
+#include <algorithm>
 #include <cassert>
 
 size_t get_new_capacity(const size_t n) {
@@ -36,10 +37,11 @@ size_t fast_vector::get_capacity() const {
     else return SMALL_SIZE;
 }
 
-void fast_vector::prepare_to_new() {
+void fast_vector::prepare_to_new(size_t capacity) {
     if (is_big() && !_data.big_data.ptr.unique()) {
-        _data.big_data.ptr.reset(copy_data(cur_data, size(), size()), destructor());
-        _data.big_data.capacity = size();
+        capacity = std::max(capacity, size());
+        _data.big_data.ptr.reset(copy_data(cur_data, size(), capacity), destructor());
+        _data.big_data.capacity = capacity;
         cur_data = _data.big_data.ptr.get();
     }
 }
@@ -80,6 +82,15 @@ uint32_t& fast_vector::operator[](size_t ind) {
     return cur_data[ind];
 }
 
+uint32_t const* fast_vector::data() const {
+    return cur_data;
+}
+
+uint32_t* fast_vector::data() {
+    assert(!(is_big() && !_data.big_data.ptr.unique()));
+    return cur_data;
+}
+
 bool operator==(const fast_vector &a, const fast_vector &b) {
     if (a._size != b._size) return 0;
     return (memcmp(a.cur_data, b.cur_data, a._size * sizeof(uint32_t)) == 0);
@@ -95,6 +106,12 @@ void fast_vector::push_back(uint32_t a) {
     _size++;
 }
 
+void fast_vector::resize(size_t nsize) {
+    if (get_capacity() < nsize) reserve(std::max(nsize, get_new_capacity(_size)));
+    if (nsize > _size) memset(cur_data + _size, 0, (nsize - _size) * sizeof(uint32_t));
+    _size = nsize;
+}
+
 void fast_vector::pop_back() {
     _size--;
 }
@@ -20,16 +20,21 @@ public:
 
     uint32_t& operator[](size_t ind);
     uint32_t const& operator[](size_t ind) const;
+    uint32_t* data();
+    uint32_t const* data() const;
 
     fast_vector& operator=(fast_vector const &other);
 
     void pop_back();
     void push_back(uint32_t a);
+    // new limbs are zero; like push_back, it writes a shared buffer, so prepare_to_new first
+    void resize(size_t nsize);
     uint32_t back();
 
     void swap(fast_vector &other) noexcept;
     friend bool operator==(const fast_vector &a, const fast_vector &b);
-    void prepare_to_new();
+    // gives a shared buffer a copy of its own, with room for capacity limbs
+    void prepare_to_new(size_t capacity = 0);
 
 private:
     size_t get_capacity() const;
@@ -0,0 +1,129 @@
+#include "product_tree.h"
+#include "number_theory.h"
+#include "thread_pool.h"
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+static size_t limbs(big_integer const& a) {
+    return a.magnitude().size();
+}
+
+// Calls f(i) for every i < n, handing the nodes to the pool in consecutive runs whose cost
+// adds up to PARALLEL_TREE_THRESHOLD limbs, so that small nodes do not become tasks each.
+template<typename Cost, typename F>
+static void for_each_node(size_t n, Cost const& cost, F const& f) {
+    task_group group;
+    size_t begin = 0, acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        acc += cost(i);
+        if (acc < PARALLEL_TREE_THRESHOLD && i + 1 < n) continue;
+        size_t end = i + 1;
+        group.run([begin, end, &f]() {
+            for (size_t j = begin; j < end; j++) f(j);
+        });
+        begin = end;
+        acc = 0;
+    }
+    group.wait();
+}
+
+product_tree::product_tree(vector<big_integer> const& values) : levels(1, values), top(1) {
+    while (levels.back().size() > 1) {
+        vector<big_integer> const& cur = levels.back();
+        vector<big_integer> next((cur.size() + 1) / 2);
+        for_each_node(cur.size() / 2, [&](size_t i) { return limbs(cur[2 * i]) + limbs(cur[2 * i + 1]); },
+                      [&](size_t i) { next[i] = cur[2 * i] * cur[2 * i + 1]; });
+        if (cur.size() % 2) next.back() = cur.back();
+        levels.push_back(move(next));
+    }
+    if (!values.empty()) top = levels.back()[0];
+}
+
+big_integer const& product_tree::product() const {
+    return top;
+}
+
+size_t product_tree::height() const {
+    return levels.size();
+}
+
+vector<big_integer> const& product_tree::level(size_t i) const {
+    return levels[i];
+}
+
+vector<big_integer> remainder_tree(big_integer const& x, product_tree const& moduli) {
+    if (moduli.level(0).empty()) return vector<big_integer>();
+    vector<big_integer> rem(1, x % moduli.product());
+    for (size_t h = moduli.height() - 1; h > 0; h--) {
+        vector<big_integer> const& below = moduli.level(h - 1);
+        vector<big_integer> next(below.size());
+        for_each_node(below.size(), [&](size_t i) { return limbs(rem[i / 2]); },
+                      [&](size_t i) { next[i] = rem[i / 2] % below[i]; });
+        rem.swap(next);
+    }
+    return rem;
+}
+
+vector<big_integer> remainder_tree(big_integer const& x, vector<big_integer> const& moduli) {
+    return remainder_tree(x, product_tree(moduli));
+}
+
+// a mod m in [0, m) for m > 0
+static big_integer mod_positive(big_integer const& a, big_integer const& m) {
+    big_integer r = a % m;
+    if (r.is_negative()) r += m;
+    return r;
+}
+
+crt_context::crt_context(vector<big_integer> const& moduli) : tree(moduli) {
+    for (size_t i = 0; i < moduli.size(); i++) {
+        if (moduli[i].is_negative() || moduli[i].is_zero()) throw runtime_error("moduli must be positive");
+    }
+    if (moduli.empty()) return;
+
+    // t = (M / P) mod P for every node P, from the root down: a child C with sibling D has
+    // M / C = (M / P) D
+    vector<big_integer> t(1, 1 % tree.product());
+    for (size_t h = tree.height() - 1; h > 0; h--) {
+        vector<big_integer> const& below = tree.level(h - 1);
+        vector<big_integer> next(below.size());
+        for_each_node(below.size(), [&](size_t i) { return limbs(below[i]); }, [&](size_t i) {
+            size_t sibling = i ^ 1;
+            next[i] = t[i / 2] % below[i];
+            if (sibling < below.size()) next[i] = next[i] * (below[sibling] % below[i]) % below[i];
+        });
+        t.swap(next);
+    }
+
+    inverses.resize(moduli.size());
+    for (size_t i = 0; i < moduli.size(); i++) {
+        xgcd_result r = xgcd(t[i], moduli[i]);
+        if (r.g != 1) throw runtime_error("moduli must be pairwise coprime");
+        inverses[i] = r.s;
+    }
+}
+
+big_integer const& crt_context::modulus() const {
+    return tree.product();
+}
+
+big_integer crt_context::reconstruct(vector<big_integer> const& residues) const {
+    vector<big_integer> const& moduli = tree.level(0);
+    if (residues.size() != moduli.size()) throw runtime_error("one residue per modulus expected");
+    if (moduli.empty()) return 0;
+
+    vector<big_integer> s(moduli.size());
+    for_each_node(moduli.size(), [&](size_t i) { return limbs(moduli[i]); },
+                  [&](size_t i) { s[i] = mod_positive(mod_positive(residues[i], moduli[i]) * inverses[i], moduli[i]); });
+    for (size_t h = 1; h < tree.height(); h++) {
+        vector<big_integer> const& below = tree.level(h - 1);
+        vector<big_integer> next((s.size() + 1) / 2);
+        for_each_node(s.size() / 2, [&](size_t i) { return limbs(below[2 * i]) + limbs(below[2 * i + 1]); },
+                      [&](size_t i) { next[i] = s[2 * i] * below[2 * i + 1] + s[2 * i + 1] * below[2 * i]; });
+        if (s.size() % 2) next.back() = s.back();
+        s.swap(next);
+    }
+    return s[0] % tree.product();
+}
@@ -0,0 +1,49 @@
+#ifndef PRODUCT_TREE_H
+#define PRODUCT_TREE_H
+
+#include "big_integer.h"
+#include <cstddef>
+#include <vector>
+
+// Nodes of a tree level are multiplied or reduced on other threads in runs of at least this
+// many limbs, when set_thread_count allows more than one.
+const size_t PARALLEL_TREE_THRESHOLD = 1024;
+
+// A balanced product tree: level 0 holds the values, every level above the products of
+// adjacent pairs, with an odd one out carried up as it is, and the top level their product.
+struct product_tree {
+    explicit product_tree(std::vector<big_integer> const& values);
+
+    // 1 for no values
+    big_integer const& product() const;
+    size_t height() const;
+    std::vector<big_integer> const& level(size_t i) const;
+
+private:
+    std::vector<std::vector<big_integer>> levels;
+    big_integer top;
+};
+
+// x % m for every value m of the tree, as operator% gives it: x is reduced modulo the
+// product and then modulo each child of a node in turn, so the divisions stay balanced.
+// The values must be nonzero.
+std::vector<big_integer> remainder_tree(big_integer const& x, product_tree const& moduli);
+std::vector<big_integer> remainder_tree(big_integer const& x, std::vector<big_integer> const& moduli);
+
+// Chinese remaindering for fixed pairwise coprime moduli m_i > 0 with product M. The tree of
+// the moduli and the inverses c_i of M / m_i mod m_i are computed once; a reconstruction is
+// then sum((r_i c_i mod m_i) M / m_i), which is put together up the tree as
+// S = S_left P_right + S_right P_left, so it costs O(M(n) log k) instead of k big products.
+struct crt_context {
+    explicit crt_context(std::vector<big_integer> const& moduli);
+
+    big_integer const& modulus() const;
+    // The x in [0, M) with x = residues[i] (mod m_i); the residues may be any integers.
+    big_integer reconstruct(std::vector<big_integer> const& residues) const;
+
+private:
+    product_tree tree;
+    std::vector<big_integer> inverses;
+};
+
+#endif
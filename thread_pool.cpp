@@ -0,0 +1,235 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct pool_task {
+    function<void()> fn;
+    task_group* group;
+};
+
+// Index of the pool worker running on this thread, -1 for user threads.
+static thread_local int current_worker = -1;
+// Whether this thread holds one of the pool's slots for running tasks.
+static thread_local bool holds_slot = false;
+
+struct thread_pool {
+    static thread_pool& instance() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    ~thread_pool() {
+        stop_workers();
+    }
+
+    size_t threads() const {
+        return workers.size() + 1;
+    }
+
+    void resize(size_t threads) {
+        stop_workers();
+        queues.clear();
+        // one deque per worker plus the injection queue fed by user threads
+        for (size_t i = 0; i < threads; i++) queues.emplace_back(new task_queue());
+        stopping = false;
+        slots = threads;
+        for (size_t i = 0; i + 1 < threads; i++) workers.emplace_back(&thread_pool::worker_loop, this, i);
+    }
+
+    void push(pool_task const& t) {
+        task_queue& q = (current_worker >= 0) ? *queues[current_worker] : *queues.back();
+        {
+            // counted under the queue lock so that a thief popping it cannot get there first
+            lock_guard<mutex> lock(q.lock);
+            q.tasks.push_back(t);
+            queued++;
+        }
+        lock_guard<mutex> lock(sleep_lock);
+        wake.notify_one();
+    }
+
+    // Every thread running tasks at depth zero holds one of threads() slots, so user
+    // threads helping in wait() come out of the same budget as the workers.
+    bool acquire_slot() {
+        size_t n = active;
+        while (n < slots) {
+            if (active.compare_exchange_weak(n, n + 1)) {
+                holds_slot = true;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void release_slot() {
+        holds_slot = false;
+        active--;
+        if (queued > 0) {
+            lock_guard<mutex> lock(sleep_lock);
+            wake.notify_one();
+        }
+    }
+
+    // Runs one queued task if there is any: the newest of this worker's own, otherwise
+    // the oldest from the injection queue or another worker.
+    bool run_one() {
+        pool_task t;
+        if (!((current_worker >= 0 && pop_back(*queues[current_worker], t)) || steal(t))) return false;
+        exception_ptr error;
+        try {
+            t.fn();
+        } catch (...) {
+            error = current_exception();
+        }
+        t.group->finish(error);
+        return true;
+    }
+
+private:
+    struct task_queue {
+        mutex lock;
+        deque<pool_task> tasks;
+    };
+
+    thread_pool() {
+        resize(1);
+    }
+
+    bool pop_back(task_queue& q, pool_task& t) {
+        lock_guard<mutex> lock(q.lock);
+        if (q.tasks.empty()) return false;
+        t = q.tasks.back();
+        q.tasks.pop_back();
+        queued--;
+        return true;
+    }
+
+    bool pop_front(task_queue& q, pool_task& t) {
+        lock_guard<mutex> lock(q.lock);
+        if (q.tasks.empty()) return false;
+        t = q.tasks.front();
+        q.tasks.pop_front();
+        queued--;
+        return true;
+    }
+
+    bool steal(pool_task& t) {
+        size_t n = queues.size();
+        if (pop_front(*queues.back(), t)) return true;
+        size_t start = (current_worker >= 0) ? current_worker + 1 : 0;
+        for (size_t i = 0; i + 1 < n; i++) {
+            size_t victim = (start + i) % (n - 1);
+            if (static_cast<int>(victim) != current_worker && pop_front(*queues[victim], t)) return true;
+        }
+        return false;
+    }
+
+    void worker_loop(size_t index) {
+        current_worker = static_cast<int>(index);
+        for (;;) {
+            if (acquire_slot()) {
+                bool ran = run_one();
+                release_slot();
+                if (ran) continue;
+            }
+            unique_lock<mutex> lock(sleep_lock);
+            wake.wait(lock, [this]() { return stopping || (queued > 0 && active < slots); });
+            if (stopping && queued == 0) return;
+        }
+    }
+
+    void stop_workers() {
+        {
+            lock_guard<mutex> lock(sleep_lock);
+            stopping = true;
+            wake.notify_all();
+        }
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+        workers.clear();
+    }
+
+    vector<unique_ptr<task_queue>> queues;
+    vector<thread> workers;
+    atomic<size_t> queued{0};
+    atomic<size_t> active{0};
+    // fixed while workers run, unlike workers.size() which grows in resize()
+    size_t slots = 1;
+    mutex sleep_lock;
+    condition_variable wake;
+    bool stopping = false;
+};
+
+void set_thread_count(size_t count) {
+    if (count == 0) count = max<size_t>(thread::hardware_concurrency(), 1);
+    thread_pool::instance().resize(count);
+}
+
+size_t get_thread_count() {
+    return thread_pool::instance().threads();
+}
+
+task_group::task_group() : pending(0) {}
+
+task_group::~task_group() {
+    join();
+}
+
+void task_group::run(function<void()> const& f) {
+    thread_pool& pool = thread_pool::instance();
+    if (pool.threads() <= 1) {
+        try {
+            f();
+        } catch (...) {
+            lock_guard<mutex> guard(lock);
+            if (!error) error = current_exception();
+        }
+        return;
+    }
+    pending++;
+    pool_task t = {f, this};
+    pool.push(t);
+}
+
+// Helps with queued tasks while this thread may run them, then sleeps until the last
+// task of the group has finished. A thread blocking here either holds no slot or holds
+// one while every task of its group is already running elsewhere, so the group always
+// makes progress.
+void task_group::join() {
+    thread_pool& pool = thread_pool::instance();
+    while (pending > 0) {
+        bool ran = false;
+        if (holds_slot) {
+            ran = pool.run_one();
+        } else if (pool.acquire_slot()) {
+            ran = pool.run_one();
+            pool.release_slot();
+        }
+        if (ran) continue;
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [this]() { return pending == 0; });
+    }
+    // finish() may still hold the lock after the last decrement
+    lock_guard<mutex> guard(lock);
+}
+
+void task_group::wait() {
+    join();
+    lock_guard<mutex> guard(lock);
+    if (error) {
+        exception_ptr e = error;
+        error = nullptr;
+        rethrow_exception(e);
+    }
+}
+
+void task_group::finish(exception_ptr e) {
+    lock_guard<mutex> guard(lock);
+    if (e && !error) error = e;
+    if (--pending == 0) done.notify_all();
+}
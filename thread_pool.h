@@ -0,0 +1,47 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+// Number of threads the parallel algorithms may use, counting the calling thread;
+// 0 means one per hardware thread. The default of 1 keeps every operation on the
+// calling thread. Workers and user threads helping in wait() share this many slots,
+// so however many user threads call in, no more than this many run tasks at once.
+// Must not be called while a parallel operation is running.
+void set_thread_count(size_t count);
+size_t get_thread_count();
+
+// Fork-join scope on top of the shared work-stealing pool.
+// Tasks forked from a worker go to the bottom of that worker's own deque; idle workers
+// steal from the top of the others'. wait() runs queued tasks while a slot is free and
+// otherwise sleeps until the group is done; nested groups cannot deadlock because a
+// task already holding a slot keeps it while it waits. With a single thread run()
+// executes its task inline.
+struct task_group {
+    task_group();
+    ~task_group();
+
+    void run(std::function<void()> const& f);
+    // Returns once every task run() so far has finished; rethrows the first exception.
+    void wait();
+
+    task_group(task_group const&) = delete;
+    task_group& operator=(task_group const&) = delete;
+
+private:
+    friend struct thread_pool;
+    void finish(std::exception_ptr error);
+    void join();
+
+    std::atomic<size_t> pending;
+    std::mutex lock;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+#endif